@@ -0,0 +1,127 @@
+// Heap bytes per song of the song list, in the row layout SongModel used to
+// have (one QMap<int, QVariant> per row) and in the current one (ids in the
+// model, records in SongCatalog, names in StringPool).
+//
+// Usage: SongMemoryBenchmark [rows]   (default 100000)
+#include "SongModel.hpp"
+#include "SongCatalog.hpp"
+#include "StringPool.hpp"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QVariant>
+#include <cstdio>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace
+{
+    // Names repeat the way they do in a real library: a few thousand
+    // artists, a few dozen genres
+    const int ArtistCount = 5000;
+    const int GenreCount = 40;
+    const int BatchSize = 1000;
+
+    enum Roles
+    {
+        IdRole = Qt::UserRole + 1,
+        TitleRole,
+        ArtistsRole,
+        FilePathRole,
+        GenresRole
+    };
+
+    qint64 heapInUse()
+    {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        return qint64(mallinfo2().uordblks);
+#else
+        return -1;
+#endif
+    }
+
+    // Built fresh for every row, as parsing a reply does
+    QJsonObject songObject(int i)
+    {
+        QJsonArray artists;
+        artists.append(QStringLiteral("Artist %1").arg(i * 7 % ArtistCount));
+        if (i % 4 == 0)
+            artists.append(QStringLiteral("Artist %1").arg(i * 13 % ArtistCount));
+        QJsonArray genres;
+        genres.append(QStringLiteral("Genre %1").arg(i % GenreCount));
+        if (i % 3 == 0)
+            genres.append(QStringLiteral("Genre %1").arg((i / 3) % GenreCount));
+
+        QJsonObject obj;
+        obj["id"] = i + 1;
+        obj["title"] = QStringLiteral("Song title number %1").arg(i);
+        obj["artists"] = artists;
+        obj["file_path"] = QStringLiteral("/music/library/album_%1/track_%2.mp3").arg(i / 12).arg(i % 12);
+        obj["genres"] = genres;
+        return obj;
+    }
+
+    // What the old SongModel parser stored for one row
+    QMap<int, QVariant> mapRow(const QJsonObject &obj)
+    {
+        QStringList artists;
+        for (const QJsonValue &artist : obj["artists"].toArray())
+            artists.append(artist.toString().trimmed());
+        QStringList genres;
+        for (const QJsonValue &genre : obj["genres"].toArray())
+            genres.append(genre.toString().trimmed());
+
+        QMap<int, QVariant> song;
+        song[IdRole] = obj["id"].toInt();
+        song[TitleRole] = obj["title"].toString().trimmed();
+        song[ArtistsRole] = artists;
+        song[FilePathRole] = obj["file_path"].toString();
+        song[GenresRole] = genres;
+        return song;
+    }
+
+    void report(const char *layout, qint64 bytes, int rows)
+    {
+        if (bytes < 0)
+            std::printf("%-28s heap usage not measurable on this platform\n", layout);
+        else
+            std::printf("%-28s %10lld bytes  %7.1f bytes/song\n", layout, static_cast<long long>(bytes), double(bytes) / rows);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int rows = argc > 1 ? qMax(QByteArray(argv[1]).toInt(), 1) : 100000;
+
+    qint64 before = heapInUse();
+    {
+        QList<QMap<int, QVariant>> songs;
+        for (int i = 0; i < rows; ++i)
+            songs.append(mapRow(songObject(i)));
+        qint64 after = heapInUse();
+        report("QMap<int, QVariant> rows", before < 0 ? -1 : after - before, rows);
+    }
+
+    before = heapInUse();
+    SongCatalog &catalog = SongCatalog::instance();
+    QList<int> ids;
+    for (int first = 0; first < rows; first += BatchSize)
+    {
+        QList<SongData> batch;
+        for (int i = first; i < qMin(first + BatchSize, rows); ++i)
+            batch.append(SongModel::parseSong(songObject(i)));
+        QList<int> batchIds = catalog.insert(batch);
+        catalog.retain(batchIds);
+        ids.append(batchIds);
+    }
+    qint64 after = heapInUse();
+    report("SongCatalog + id list", before < 0 ? -1 : after - before, rows);
+    report("  memoryUsage() estimate", catalog.memoryUsage() + ids.capacity() * qint64(sizeof(int)), rows);
+    std::printf("%d rows, %d interned names\n", rows, StringPool::instance().size());
+
+    catalog.release(ids);
+    return 0;
+}
\ No newline at end of file
@@ -225,4 +225,82 @@ QString AppConfig::getPlaylistsDeleteEndpoint(int playlistId) const
     QString url = endpoint + "/" + QString::number(playlistId);
     qDebug() << "AppConfig: Generated PLAYLISTS_DELETE_ENDPOINT:" << url;
     return url;
+}
+
+qint64 AppConfig::getHttpCacheMaxSize() const
+{
+    qint64 sizeMb = envVariables.value("HTTP_CACHE_MAX_SIZE_MB", "64").toLongLong();
+    return qMax<qint64>(sizeMb, 1) * 1024 * 1024;
+}
+
+int AppConfig::getSongPageSize() const
+{
+    return qMax(envVariables.value("SONG_PAGE_SIZE", "200").toInt(), 1);
+}
+
+int AppConfig::getSongPrefetchDistance() const
+{
+    return qMax(envVariables.value("SONG_PREFETCH_DISTANCE", "50").toInt(), 0);
+}
+
+qint64 AppConfig::getStreamCacheMaxSize() const
+{
+    qint64 sizeMb = envVariables.value("STREAM_CACHE_MAX_SIZE_MB", "512").toLongLong();
+    return qMax<qint64>(sizeMb, 1) * 1024 * 1024;
+}
+
+int AppConfig::getPrefetchTrackCount() const
+{
+    return qMax(envVariables.value("PREFETCH_TRACK_COUNT", "3").toInt(), 0);
+}
+
+qint64 AppConfig::getPrefetchMaxRate() const
+{
+    // 0 disables the cap
+    qint64 kbps = envVariables.value("PREFETCH_MAX_KBPS", "512").toLongLong();
+    return qMax<qint64>(kbps, 0) * 1000 / 8;
+}
+
+qint64 AppConfig::getShuffleSeed() const
+{
+    // Negative leaves shuffle randomly seeded
+    return envVariables.value("SHUFFLE_SEED", "-1").toLongLong();
+}
+
+bool AppConfig::isAudioEngineEnabled() const
+{
+    return envVariables.value("AUDIO_ENGINE_ENABLED", "0").toInt() != 0;
+}
+
+int AppConfig::getCrossfadeMs() const
+{
+    return qMax(envVariables.value("CROSSFADE_MS", "3000").toInt(), 0);
+}
+
+bool AppConfig::isLoudnessNormalizationEnabled() const
+{
+    return envVariables.value("LOUDNESS_NORMALIZATION", "1").toInt() != 0;
+}
+
+bool AppConfig::isSeekIndexEnabled() const
+{
+    // Off decodes from the start on every seek, for comparing seek latency
+    return envVariables.value("SEEK_INDEX_ENABLED", "1").toInt() != 0;
+}
+
+int AppConfig::getPositionNotifyMs() const
+{
+    // 0 follows the display refresh rate; low-power devices can ask for less
+    return qMax(envVariables.value("POSITION_NOTIFY_MS", "0").toInt(), 0);
+}
+
+QString AppConfig::getPlaybackMetricsFile() const
+{
+    // Empty keeps the time-to-first-audio histograms in memory only
+    return envVariables.value("PLAYBACK_METRICS_FILE", "");
+}
+
+int AppConfig::getGaplessLeadTimeMs() const
+{
+    return qMax(envVariables.value("GAPLESS_LEAD_TIME_MS", "5000").toInt(), 0);
 }
\ No newline at end of file
@@ -38,6 +38,21 @@ public:
     QString getPlaylistsRemoveSongEndpoint() const;
     QString getPlaylistsDeleteEndpoint(int playlistId) const;
 
+    qint64 getHttpCacheMaxSize() const;
+    int getSongPageSize() const;
+    int getSongPrefetchDistance() const;
+    int getGaplessLeadTimeMs() const;
+    qint64 getStreamCacheMaxSize() const;
+    int getPrefetchTrackCount() const;
+    qint64 getPrefetchMaxRate() const;
+    qint64 getShuffleSeed() const;
+    bool isAudioEngineEnabled() const;
+    int getCrossfadeMs() const;
+    bool isLoudnessNormalizationEnabled() const;
+    bool isSeekIndexEnabled() const;
+    int getPositionNotifyMs() const;
+    QString getPlaybackMetricsFile() const;
+
 private:
     AppConfig() = default;
     QMap<QString, QString> envVariables;
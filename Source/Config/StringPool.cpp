@@ -0,0 +1,54 @@
+#include "StringPool.hpp"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+StringPool &StringPool::instance()
+{
+    static StringPool instance;
+    return instance;
+}
+
+quint32 StringPool::intern(const QString &str)
+{
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_ids.constFind(str);
+        if (it != m_ids.constEnd())
+            return it.value();
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_ids.constFind(str);
+    if (it != m_ids.constEnd())
+        return it.value();
+
+    quint32 id = static_cast<quint32>(m_strings.size());
+    m_strings.append(str);
+    m_ids.insert(str, id);
+    return id;
+}
+
+QString StringPool::value(quint32 id) const
+{
+    QReadLocker locker(&m_lock);
+    return id < static_cast<quint32>(m_strings.size()) ? m_strings.at(id) : QString();
+}
+
+QStringList StringPool::values(const quint32 *ids, int count) const
+{
+    QStringList result;
+    result.reserve(count);
+    QReadLocker locker(&m_lock);
+    for (int i = 0; i < count; ++i)
+    {
+        if (ids[i] < static_cast<quint32>(m_strings.size()))
+            result.append(m_strings.at(ids[i]));
+    }
+    return result;
+}
+
+int StringPool::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_strings.size();
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+
+// Process-wide interning table for short, highly repeated strings such as
+// artist and genre names. Each distinct string is stored once and referred
+// to by a small integer id; lookups by id are safe from any thread.
+class StringPool
+{
+public:
+    static StringPool &instance();
+
+    quint32 intern(const QString &str);
+    QString value(quint32 id) const;
+    QStringList values(const quint32 *ids, int count) const;
+    int size() const;
+
+private:
+    StringPool() = default;
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_ids;
+    QList<QString> m_strings;
+};
\ No newline at end of file
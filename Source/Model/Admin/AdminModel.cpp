@@ -1,6 +1,7 @@
 #include "AdminModel.hpp"
 #include "AppState.hpp"
 #include "AppConfig.hpp"
+#include "HttpClient.hpp"
 #include <QNetworkRequest>
 #include <QHttpMultiPart>
 #include <QJsonDocument>
@@ -12,7 +13,7 @@
 #include <QUrlQuery>
 
 AdminModel::AdminModel(QObject *parent)
-    : QObject(parent), m_networkManager(new QNetworkAccessManager(this))
+    : QObject(parent)
 {
 }
 
@@ -33,7 +34,6 @@ void AdminModel::uploadSong(const QString &title, const QString &genres, const Q
         emit uploadFinished(false, "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
     if (title.isEmpty() || genres.isEmpty() || artists.isEmpty() || filePath.isEmpty())
     {
@@ -122,7 +122,7 @@ void AdminModel::uploadSong(const QString &title, const QString &genres, const Q
     multiPart->append(filePart);
 
     qDebug() << "AdminModel: Sending upload request to" << url.toString();
-    QNetworkReply *reply = m_networkManager->post(request, multiPart);
+    QNetworkReply *reply = HttpClient::instance()->post(request, multiPart);
     multiPart->setParent(reply);
 
     connect(reply, &QNetworkReply::finished, this, [=]()
@@ -211,7 +211,6 @@ void AdminModel::updateSong(int songId, const QString &title, const QString &gen
         emit updateFinished(false, "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
     if (title.isEmpty() && genres.isEmpty() && artists.isEmpty())
     {
@@ -245,7 +244,7 @@ void AdminModel::updateSong(int songId, const QString &title, const QString &gen
 
     QJsonDocument doc(json);
     qDebug() << "AdminModel: Update song payload:" << QString(doc.toJson(QJsonDocument::Compact));
-    QNetworkReply *reply = m_networkManager->put(request, doc.toJson());
+    QNetworkReply *reply = HttpClient::instance()->put(request, doc.toJson());
 
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
@@ -330,9 +329,8 @@ void AdminModel::deleteSong(int songId)
         emit deleteFinished(false, "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
-    QNetworkReply *reply = m_networkManager->deleteResource(request);
+    QNetworkReply *reply = HttpClient::instance()->deleteResource(request);
 
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
@@ -415,10 +413,9 @@ void AdminModel::fetchSongById(int songId)
         emit songFetched(false, "", "", "", "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
     qDebug() << "AdminModel: Fetching song with ID:" << songId << "from" << url.toString();
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
 
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
@@ -512,10 +509,9 @@ void AdminModel::fetchAllUsers()
         emit usersFetched(false, QVariantList(), "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
     qDebug() << "AdminModel: Fetching all users from" << url.toString();
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
 
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
@@ -614,10 +610,9 @@ void AdminModel::searchUsersByName(const QString &name)
         emit usersFetched(false, QVariantList(), "No authentication token available");
         return;
     }
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(token).toUtf8());
 
     qDebug() << "AdminModel: Searching users with name:" << name << "from" << url.toString();
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
 
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
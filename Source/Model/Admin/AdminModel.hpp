@@ -1,7 +1,6 @@
 #pragma once
 
 #include <QObject>
-#include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QFile>
 
@@ -25,7 +24,4 @@ signals:
     void deleteFinished(bool success, const QString &message);
     void songFetched(bool success, const QString &title, const QString &genres, const QString &artists, const QString &errorMessage = "");
     void usersFetched(bool success, const QVariantList &users, const QString &errorMessage = "");
-
-private:
-    QNetworkAccessManager *m_networkManager;
 };
@@ -0,0 +1,186 @@
+#include "AudioEngine.hpp"
+#include "AudioMixer.hpp"
+#include "TrackDecoder.hpp"
+#include "CachedStream.hpp"
+#include <QThread>
+#include <QTimer>
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QDebug>
+
+namespace
+{
+    constexpr int PositionIntervalMs = 50;
+}
+
+AudioEngine::AudioEngine(QObject *parent)
+    : QObject(parent), m_decodeThread(new QThread(this)), m_outputThread(new QThread(this)), m_positionTimer(new QTimer(this))
+{
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    QAudioFormat format;
+    format.setSampleRate(device.preferredFormat().sampleRate());
+    format.setChannelCount(AudioMixer::Channels);
+    format.setSampleFormat(QAudioFormat::Float);
+    if (device.isNull() || !device.isFormatSupported(format))
+    {
+        qDebug() << "AudioEngine: Output device does not support" << format;
+        return;
+    }
+
+    m_mixer = new AudioMixer(device, format);
+    for (int i = 0; i < 2; ++i)
+    {
+        m_decoders[i] = new TrackDecoder(m_mixer->ring(i), format);
+        m_decoders[i]->moveToThread(m_decodeThread);
+        connect(m_decodeThread, &QThread::finished, m_decoders[i], &QObject::deleteLater);
+    }
+    m_mixer->setDecoders(m_decoders[0], m_decoders[1]);
+    m_mixer->moveToThread(m_outputThread);
+    connect(m_outputThread, &QThread::finished, m_mixer, &QObject::deleteLater);
+
+    connect(m_mixer, &AudioMixer::durationChanged, this, &AudioEngine::durationChanged);
+    connect(m_mixer, &AudioMixer::nextTrackStarted, this, [this]()
+            {
+        m_currentUrl = m_nextUrl;
+        m_nextUrl.clear();
+        emit nextTrackStarted(); });
+    connect(m_mixer, &AudioMixer::trackFinished, this, &AudioEngine::onTrackFinished);
+    connect(m_mixer, &AudioMixer::errorOccurred, this, &AudioEngine::errorOccurred);
+
+    m_positionTimer->setInterval(PositionIntervalMs);
+    connect(m_positionTimer, &QTimer::timeout, this, &AudioEngine::onPositionTick);
+
+    m_decodeThread->start();
+    m_outputThread->start(QThread::TimeCriticalPriority);
+    QMetaObject::invokeMethod(m_mixer, &AudioMixer::start);
+}
+
+AudioEngine::~AudioEngine()
+{
+    if (m_mixer)
+        QMetaObject::invokeMethod(m_mixer, &AudioMixer::shutdown, Qt::BlockingQueuedConnection);
+    // Decoders write into the mixer's rings, so they go first
+    m_decodeThread->quit();
+    m_decodeThread->wait();
+    m_outputThread->quit();
+    m_outputThread->wait();
+}
+
+qint64 AudioEngine::position() const
+{
+    return m_mixer ? m_mixer->position() : 0;
+}
+
+qint64 AudioEngine::duration() const
+{
+    return m_mixer ? m_mixer->duration() : 0;
+}
+
+void AudioEngine::play(const QUrl &url, qreal trackGain, CachedStream *stream)
+{
+    if (!m_mixer)
+    {
+        delete stream;
+        return;
+    }
+    // Read by the decoder, which lives on the decode thread
+    if (stream)
+        stream->moveToThread(m_decodeThread);
+    AudioMixer *mixer = m_mixer;
+    QMetaObject::invokeMethod(mixer, [mixer, url, trackGain, stream]()
+                              { mixer->play(url, trackGain, stream); });
+    m_currentUrl = url;
+    m_nextUrl.clear();
+    m_lastPosition = -1;
+    setPlaying(true);
+}
+
+void AudioEngine::queueNext(const QUrl &url, int crossfadeMs, qreal trackGain, CachedStream *stream)
+{
+    if (!m_mixer)
+    {
+        delete stream;
+        return;
+    }
+    if (stream)
+        stream->moveToThread(m_decodeThread);
+    AudioMixer *mixer = m_mixer;
+    QMetaObject::invokeMethod(mixer, [mixer, url, crossfadeMs, trackGain, stream]()
+                              { mixer->queueNext(url, crossfadeMs, trackGain, stream); });
+    m_nextUrl = url;
+}
+
+void AudioEngine::clearNext()
+{
+    if (m_mixer)
+        QMetaObject::invokeMethod(m_mixer, &AudioMixer::clearNext);
+}
+
+void AudioEngine::pause()
+{
+    if (!m_mixer)
+        return;
+    QMetaObject::invokeMethod(m_mixer, &AudioMixer::pause);
+    setPlaying(false);
+}
+
+void AudioEngine::resume()
+{
+    if (!m_mixer)
+        return;
+    QMetaObject::invokeMethod(m_mixer, &AudioMixer::resume);
+    setPlaying(true);
+}
+
+void AudioEngine::stop()
+{
+    if (!m_mixer)
+        return;
+    QMetaObject::invokeMethod(m_mixer, &AudioMixer::stop);
+    setPlaying(false);
+}
+
+void AudioEngine::setPosition(qint64 position, qint64 byteOffset, qint64 byteOffsetMs)
+{
+    if (!m_mixer)
+        return;
+    AudioMixer *mixer = m_mixer;
+    QUrl url = m_currentUrl;
+    QMetaObject::invokeMethod(mixer, [mixer, url, position, byteOffset, byteOffsetMs]()
+                              { mixer->seek(position, url, byteOffset, byteOffsetMs); });
+}
+
+void AudioEngine::setVolume(qreal volume)
+{
+    // Not queued: the mixer only reads the latest value
+    if (m_mixer)
+        m_mixer->setVolume(volume);
+}
+
+void AudioEngine::setPlaying(bool playing)
+{
+    if (playing)
+        m_positionTimer->start();
+    else
+        m_positionTimer->stop();
+    if (m_playing == playing)
+        return;
+    m_playing = playing;
+    emit playingChanged();
+}
+
+void AudioEngine::onPositionTick()
+{
+    qint64 current = position();
+    if (current == m_lastPosition)
+        return;
+    m_lastPosition = current;
+    emit positionChanged(current);
+}
+
+void AudioEngine::onTrackFinished()
+{
+    onPositionTick();
+    setPlaying(false);
+    emit finished();
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <QObject>
+#include <QUrl>
+
+class QThread;
+class QTimer;
+class AudioMixer;
+class CachedStream;
+class TrackDecoder;
+
+// Playback engine that can overlap two songs, as an alternative to
+// QMediaPlayer. Songs are decoded on a worker thread and mixed into a
+// QAudioSink on an output thread, so a busy GUI thread does not cause
+// underruns. The GUI side only forwards commands and polls the position.
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioEngine(QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // False if the default output device cannot take stereo float
+    bool isAvailable() const { return m_mixer != nullptr; }
+    bool isPlaying() const { return m_playing; }
+    qint64 position() const;
+    qint64 duration() const;
+
+    // trackGain is the song's own linear gain, e.g. from loudness normalization.
+    // The engine takes over a stream of the song from the cache and decodes
+    // it instead of fetching url.
+    void play(const QUrl &url, qreal trackGain = 1.0, CachedStream *stream = nullptr);
+    // The queued song follows the current one gaplessly, or overlaps its
+    // last crossfadeMs milliseconds
+    void queueNext(const QUrl &url, int crossfadeMs, qreal trackGain = 1.0, CachedStream *stream = nullptr);
+    void clearNext();
+    void pause();
+    void resume();
+    void stop();
+    // byteOffset and byteOffsetMs are the seek index point at or before
+    // position; without one the song is decoded again from its start
+    void setPosition(qint64 position, qint64 byteOffset = 0, qint64 byteOffsetMs = 0);
+    // Cheap enough to call for every knob step
+    void setVolume(qreal volume);
+
+signals:
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
+    void playingChanged();
+    void nextTrackStarted();
+    void finished();
+    void errorOccurred(const QString &error);
+
+private slots:
+    void onPositionTick();
+    void onTrackFinished();
+
+private:
+    void setPlaying(bool playing);
+
+    QThread *m_decodeThread;
+    QThread *m_outputThread;
+    AudioMixer *m_mixer = nullptr;
+    TrackDecoder *m_decoders[2] = {nullptr, nullptr};
+    QTimer *m_positionTimer;
+    bool m_playing = false;
+    // What the offsets given to setPosition() refer to, as far as this thread knows
+    QUrl m_currentUrl;
+    QUrl m_nextUrl;
+    qint64 m_lastPosition = -1;
+};
\ No newline at end of file
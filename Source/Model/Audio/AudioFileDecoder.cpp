@@ -0,0 +1,73 @@
+#include "AudioFileDecoder.hpp"
+#include "TrackDecoder.hpp"
+#include <QAudioDecoder>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUrl>
+#include <QList>
+#include <QDebug>
+
+namespace
+{
+    constexpr int PausePollMs = 200;
+}
+
+AudioFileDecoder::Result AudioFileDecoder::decode(const QString &filePath, const Consumer &consume,
+                                                  const std::atomic<bool> *cancelled, const std::atomic<bool> *paused)
+{
+    QAudioDecoder decoder;
+    QAudioFormat format;
+    format.setSampleRate(48000);
+    format.setChannelCount(2);
+    format.setSampleFormat(QAudioFormat::Float);
+    decoder.setAudioFormat(format);
+    decoder.setSource(QUrl::fromLocalFile(filePath));
+
+    QEventLoop loop;
+    QTimer pausePoll;
+    pausePoll.setSingleShot(true);
+    pausePoll.setInterval(PausePollMs);
+    QList<float> samples;
+    Result result = Finished;
+
+    auto drain = [&](bool force)
+    {
+        if (cancelled->load())
+        {
+            result = Cancelled;
+            loop.quit();
+            return;
+        }
+        if (paused && paused->load() && !force)
+        {
+            pausePoll.start();
+            return;
+        }
+        while (decoder.bufferAvailable())
+        {
+            QAudioBuffer buffer = decoder.read();
+            if (!buffer.isValid())
+                continue;
+            TrackDecoder::toStereo(buffer, &samples);
+            consume(samples.constData(), int(samples.size() / 2), buffer.format().sampleRate());
+        }
+    };
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&]()
+                     { drain(false); });
+    QObject::connect(&pausePoll, &QTimer::timeout, &loop, [&]()
+                     { drain(false); });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&]()
+                     {
+        drain(true);
+        loop.quit(); });
+    QObject::connect(&decoder, &QAudioDecoder::error, &loop, [&]()
+                     {
+        qDebug() << "AudioFileDecoder: Could not decode" << filePath << decoder.errorString();
+        result = Failed;
+        loop.quit(); });
+
+    decoder.start();
+    loop.exec();
+    decoder.stop();
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// Decodes a local audio file from start to end on the calling thread, for
+// background jobs on pool threads. QAudioDecoder needs an event loop, so one
+// runs locally until the file is done. Audio is handed over in blocks of
+// interleaved stereo float; while paused, decoded buffers are left unread,
+// which holds the decoder back as well.
+class AudioFileDecoder
+{
+public:
+    enum Result
+    {
+        Finished,
+        Failed,
+        Cancelled
+    };
+
+    // consume(samples, frames, sampleRate)
+    using Consumer = std::function<void(const float *, int, int)>;
+
+    static Result decode(const QString &filePath, const Consumer &consume,
+                         const std::atomic<bool> *cancelled, const std::atomic<bool> *paused = nullptr);
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "AudioGain.hpp"
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#define AUDIO_GAIN_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIO_GAIN_NEON
+#endif
+
+void AudioGain::apply(float *samples, int count, float gain)
+{
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 g8 = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), g8));
+#endif
+#if defined(AUDIO_GAIN_SSE)
+    const __m128 g4 = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g4));
+#elif defined(AUDIO_GAIN_NEON)
+    const float32x4_t g4 = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), g4));
+#endif
+    for (; i < count; ++i)
+        samples[i] *= gain;
+}
+
+void AudioGain::mix(float *out, const float *in, int count, float gain)
+{
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 g8 = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), g8)));
+#endif
+#if defined(AUDIO_GAIN_SSE)
+    const __m128 g4 = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g4)));
+#elif defined(AUDIO_GAIN_NEON)
+    const float32x4_t g4 = vdupq_n_f32(gain);
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(in + i), g4));
+#endif
+    for (; i < count; ++i)
+        out[i] += in[i] * gain;
+}
+
+// The gain of frame k is gain + step * (k + 1); it is computed from the
+// frame index rather than accumulated, so long ramps do not drift
+float AudioGain::applyRamp(float *samples, int frames, float gain, float step)
+{
+    int frame = 0;
+#if defined(AUDIO_GAIN_SSE)
+    // Two stereo frames per vector: lanes are L0 R0 L1 R1
+    const __m128 offsets = _mm_setr_ps(1.0f, 1.0f, 2.0f, 2.0f);
+    const __m128 s4 = _mm_set1_ps(step);
+    for (; frame + 2 <= frames; frame += 2)
+    {
+        __m128 g = _mm_add_ps(_mm_set1_ps(gain + step * frame), _mm_mul_ps(offsets, s4));
+        _mm_storeu_ps(samples + frame * 2, _mm_mul_ps(_mm_loadu_ps(samples + frame * 2), g));
+    }
+#elif defined(AUDIO_GAIN_NEON)
+    const float offsetValues[4] = {1.0f, 1.0f, 2.0f, 2.0f};
+    const float32x4_t offsets = vld1q_f32(offsetValues);
+    for (; frame + 2 <= frames; frame += 2)
+    {
+        float32x4_t g = vmlaq_n_f32(vdupq_n_f32(gain + step * frame), offsets, step);
+        vst1q_f32(samples + frame * 2, vmulq_f32(vld1q_f32(samples + frame * 2), g));
+    }
+#endif
+    for (; frame < frames; ++frame)
+    {
+        float g = gain + step * (frame + 1);
+        samples[frame * 2] *= g;
+        samples[frame * 2 + 1] *= g;
+    }
+    return gain + step * frames;
+}
+
+float AudioGain::mixRamp(float *out, const float *in, int frames, float gain, float step)
+{
+    int frame = 0;
+#if defined(AUDIO_GAIN_SSE)
+    const __m128 offsets = _mm_setr_ps(1.0f, 1.0f, 2.0f, 2.0f);
+    const __m128 s4 = _mm_set1_ps(step);
+    for (; frame + 2 <= frames; frame += 2)
+    {
+        __m128 g = _mm_add_ps(_mm_set1_ps(gain + step * frame), _mm_mul_ps(offsets, s4));
+        __m128 mixed = _mm_add_ps(_mm_loadu_ps(out + frame * 2), _mm_mul_ps(_mm_loadu_ps(in + frame * 2), g));
+        _mm_storeu_ps(out + frame * 2, mixed);
+    }
+#elif defined(AUDIO_GAIN_NEON)
+    const float offsetValues[4] = {1.0f, 1.0f, 2.0f, 2.0f};
+    const float32x4_t offsets = vld1q_f32(offsetValues);
+    for (; frame + 2 <= frames; frame += 2)
+    {
+        float32x4_t g = vmlaq_n_f32(vdupq_n_f32(gain + step * frame), offsets, step);
+        vst1q_f32(out + frame * 2, vmlaq_f32(vld1q_f32(out + frame * 2), vld1q_f32(in + frame * 2), g));
+    }
+#endif
+    for (; frame < frames; ++frame)
+    {
+        float g = gain + step * (frame + 1);
+        out[frame * 2] += in[frame * 2] * g;
+        out[frame * 2 + 1] += in[frame * 2 + 1] * g;
+    }
+    return gain + step * frames;
+}
\ No newline at end of file
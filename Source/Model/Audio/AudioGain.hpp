@@ -0,0 +1,15 @@
+#pragma once
+
+// Gain stages over interleaved stereo float samples, vectorised with
+// AVX, SSE or NEON depending on what the build targets. Ramps move the
+// gain by step every frame, starting with the first frame, and return the
+// gain reached so a ramp can continue in the next block.
+class AudioGain
+{
+public:
+    static void apply(float *samples, int count, float gain);
+    static float applyRamp(float *samples, int frames, float gain, float step);
+    // out += in * gain
+    static void mix(float *out, const float *in, int count, float gain);
+    static float mixRamp(float *out, const float *in, int frames, float gain, float step);
+};
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "AudioMixer.hpp"
+#include "TrackDecoder.hpp"
+#include "AudioGain.hpp"
+#include <QAudioSink>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Decoding runs ahead of playback by this much per deck
+    constexpr int RingSeconds = 2;
+    constexpr qint64 FrameBytes = AudioMixer::Channels * sizeof(float);
+    // Volume ramps take this long for the full range, and never less than the minimum
+    constexpr int VolumeFullRampMs = 100;
+    constexpr int VolumeMinRampMs = 5;
+}
+
+AudioMixer::AudioMixer(const QAudioDevice &device, const QAudioFormat &format, QObject *parent)
+    : QIODevice(parent), m_device(device), m_format(format)
+{
+    for (Deck &deck : m_decks)
+        deck.ring = std::make_unique<AudioRingBuffer>(format.sampleRate() * Channels * RingSeconds);
+}
+
+AudioMixer::~AudioMixer()
+{
+    shutdown();
+}
+
+void AudioMixer::setDecoders(TrackDecoder *first, TrackDecoder *second)
+{
+    TrackDecoder *decoders[2] = {first, second};
+    for (int i = 0; i < 2; ++i)
+    {
+        m_decks[i].decoder = decoders[i];
+        connect(decoders[i], &TrackDecoder::started, this, [this, i](int generation)
+                { onDeckStarted(i, generation); });
+        connect(decoders[i], &TrackDecoder::durationChanged, this, [this, i](qint64 durationMs, int generation)
+                { onDeckDuration(i, durationMs, generation); });
+        connect(decoders[i], &TrackDecoder::finished, this, [this, i](int generation)
+                { onDeckFinished(i, generation); });
+        connect(decoders[i], &TrackDecoder::errorOccurred, this, [this, i](const QString &error, int generation)
+                { onDeckError(i, error, generation); });
+    }
+}
+
+void AudioMixer::start()
+{
+    if (m_sink)
+        return;
+    open(QIODevice::ReadOnly);
+    m_sink = new QAudioSink(m_device, m_format, this);
+    connect(m_sink, &QAudioSink::stateChanged, this, [this](QAudio::State state)
+            {
+        if (state == QAudio::StoppedState && m_sink->error() != QAudio::NoError)
+        {
+            qDebug() << "AudioMixer: Audio output stopped with error" << m_sink->error();
+            emit errorOccurred(tr("Audio output failed"));
+        } });
+    m_sink->start(this);
+    m_sink->suspend();
+}
+
+void AudioMixer::shutdown()
+{
+    if (!m_sink)
+        return;
+    m_sink->stop();
+    delete m_sink;
+    m_sink = nullptr;
+    close();
+}
+
+qint64 AudioMixer::bytesAvailable() const
+{
+    // Always has data; silence when nothing plays
+    return std::numeric_limits<int>::max();
+}
+
+void AudioMixer::loadDeck(Deck &deck, const QUrl &url, qint64 startMs, qint64 byteOffset, qint64 byteOffsetMs,
+                          CachedStream *stream)
+{
+    deck.url = url;
+    deck.state = Loading;
+    deck.decodeFinished = false;
+    deck.fadingOut = false;
+    deck.playedFrames = startMs * m_format.sampleRate() / 1000;
+    deck.gain = 1.0f;
+    deck.targetGain = 1.0f;
+    deck.rampFrames = 0;
+    int generation = ++deck.generation;
+    TrackDecoder *decoder = deck.decoder;
+    QMetaObject::invokeMethod(decoder, [decoder, url, startMs, generation, byteOffset, byteOffsetMs, stream]()
+                              { decoder->load(url, startMs, generation, byteOffset, byteOffsetMs, stream); });
+}
+
+void AudioMixer::stopDeck(Deck &deck)
+{
+    if (deck.state == Idle)
+        return;
+    deck.state = Idle;
+    deck.fadingOut = false;
+    int generation = ++deck.generation;
+    TrackDecoder *decoder = deck.decoder;
+    QMetaObject::invokeMethod(decoder, [decoder, generation]()
+                              { decoder->stop(generation); });
+}
+
+void AudioMixer::play(const QUrl &url, qreal trackGain, CachedStream *stream)
+{
+    stopDeck(otherDeck());
+    m_awaitingNext = false;
+    loadDeck(activeDeck(), url, 0, 0, 0, stream);
+    activeDeck().totalFrames = -1;
+    activeDeck().trackGain = float(trackGain);
+    m_position.store(0, std::memory_order_relaxed);
+    m_duration.store(0, std::memory_order_relaxed);
+    resume();
+}
+
+void AudioMixer::queueNext(const QUrl &url, int crossfadeMs, qreal trackGain, CachedStream *stream)
+{
+    // A tail still fading out gives way to the new song
+    Deck &next = otherDeck();
+    stopDeck(next);
+    m_fadeFrames = qint64(qMax(crossfadeMs, 0)) * m_format.sampleRate() / 1000;
+    loadDeck(next, url, 0, 0, 0, stream);
+    next.totalFrames = -1;
+    next.trackGain = float(trackGain);
+}
+
+void AudioMixer::clearNext()
+{
+    Deck &next = otherDeck();
+    if (!next.fadingOut)
+        stopDeck(next);
+    m_awaitingNext = false;
+}
+
+void AudioMixer::pause()
+{
+    if (m_sink)
+        m_sink->suspend();
+}
+
+void AudioMixer::resume()
+{
+    if (m_sink)
+        m_sink->resume();
+}
+
+void AudioMixer::stop()
+{
+    stopDeck(m_decks[0]);
+    stopDeck(m_decks[1]);
+    m_awaitingNext = false;
+    m_position.store(0, std::memory_order_relaxed);
+    pause();
+}
+
+void AudioMixer::seek(qint64 positionMs, const QUrl &url, qint64 byteOffset, qint64 byteOffsetMs)
+{
+    Deck &deck = activeDeck();
+    if (deck.url.isEmpty())
+        return;
+    Deck &other = otherDeck();
+    if (other.fadingOut)
+        stopDeck(other);
+    m_awaitingNext = false;
+    // QAudioDecoder cannot seek, so the song is decoded again, from the
+    // indexed frame before the target if there is one, else from the start
+    if (url != deck.url)
+        byteOffset = 0;
+    qint64 totalFrames = deck.totalFrames;
+    loadDeck(deck, deck.url, qMax<qint64>(positionMs, 0), byteOffset, byteOffsetMs);
+    deck.totalFrames = totalFrames;
+    m_position.store(qMax<qint64>(positionMs, 0), std::memory_order_relaxed);
+}
+
+void AudioMixer::setVolume(qreal volume)
+{
+    m_targetVolume.store(float(qBound<qreal>(0.0, volume, 1.0)), std::memory_order_relaxed);
+}
+
+void AudioMixer::applyVolume(float *out, int frames)
+{
+    // Picks up the latest target once per block and ramps from wherever the
+    // gain is now, so intermediate targets never get their own ramp
+    float target = m_targetVolume.load(std::memory_order_relaxed);
+    if (target != m_volumeRampTarget)
+    {
+        m_volumeRampTarget = target;
+        const int rate = m_format.sampleRate();
+        qint64 rampFrames = qint64(std::abs(target - m_volume) * VolumeFullRampMs * rate / 1000);
+        m_volumeRampFrames = qMax<qint64>(rampFrames, VolumeMinRampMs * rate / 1000);
+        m_volumeStep = (target - m_volume) / m_volumeRampFrames;
+    }
+
+    int ramped = int(qMin<qint64>(m_volumeRampFrames, frames));
+    if (ramped > 0)
+    {
+        m_volume = AudioGain::applyRamp(out, ramped, m_volume, m_volumeStep);
+        m_volumeRampFrames -= ramped;
+        if (m_volumeRampFrames == 0)
+            m_volume = m_volumeRampTarget;
+    }
+    if (m_volume != 1.0f)
+        AudioGain::apply(out + ramped * Channels, (frames - ramped) * Channels, m_volume);
+}
+
+qint64 AudioMixer::remainingFrames(const Deck &deck) const
+{
+    if (deck.decodeFinished)
+        return deck.ring->available() / Channels;
+    if (deck.totalFrames > 0)
+        return qMax<qint64>(deck.totalFrames - deck.playedFrames, 0);
+    return std::numeric_limits<qint64>::max();
+}
+
+void AudioMixer::startNext(bool crossfade)
+{
+    Deck &previous = activeDeck();
+    m_active = 1 - m_active;
+    Deck &next = activeDeck();
+    next.state = Playing;
+    m_awaitingNext = false;
+
+    if (crossfade && m_fadeFrames > 0 && previous.state == Playing)
+    {
+        next.gain = 0.0f;
+        next.targetGain = 1.0f;
+        next.gainStep = 1.0f / m_fadeFrames;
+        next.rampFrames = m_fadeFrames;
+        previous.targetGain = 0.0f;
+        previous.gainStep = -previous.gain / m_fadeFrames;
+        previous.rampFrames = m_fadeFrames;
+        previous.fadingOut = true;
+    }
+    else
+    {
+        next.gain = 1.0f;
+        next.rampFrames = 0;
+        stopDeck(previous);
+    }
+
+    publishDuration(next);
+    m_position.store(next.playedFrames * 1000 / m_format.sampleRate(), std::memory_order_relaxed);
+    emit nextTrackStarted();
+}
+
+int AudioMixer::mixDeck(Deck &deck, float *out, int frames)
+{
+    if (m_scratch.size() < size_t(frames) * Channels)
+        m_scratch.resize(size_t(frames) * Channels);
+    const float *in = m_scratch.data();
+    int read = deck.ring->read(m_scratch.data(), frames * Channels) / Channels;
+    if (deck.trackGain != 1.0f)
+        AudioGain::apply(m_scratch.data(), read * Channels, deck.trackGain);
+
+    int ramped = int(qMin<qint64>(deck.rampFrames, read));
+    if (ramped > 0)
+    {
+        deck.gain = AudioGain::mixRamp(out, in, ramped, deck.gain, deck.gainStep);
+        deck.rampFrames -= ramped;
+        if (deck.rampFrames == 0)
+            deck.gain = deck.targetGain;
+    }
+    AudioGain::mix(out + ramped * Channels, in + ramped * Channels, (read - ramped) * Channels, deck.gain);
+
+    deck.playedFrames += read;
+    return read;
+}
+
+qint64 AudioMixer::readData(char *data, qint64 maxSize)
+{
+    const int frames = int(qMin<qint64>(maxSize / FrameBytes, std::numeric_limits<int>::max() / Channels));
+    float *out = reinterpret_cast<float *>(data);
+    std::fill_n(out, size_t(frames) * Channels, 0.0f);
+
+    Deck &active = activeDeck();
+    if (active.state == Playing && otherDeck().state == Ready && m_fadeFrames > 0 && remainingFrames(active) <= m_fadeFrames)
+        startNext(true);
+
+    // Tail of the previous song under the start of the new one
+    Deck &tail = otherDeck();
+    if (tail.fadingOut)
+    {
+        int mixed = mixDeck(tail, out, frames);
+        if (tail.gain <= 0.0f || (mixed < frames && tail.decodeFinished))
+            stopDeck(tail);
+    }
+
+    Deck &current = activeDeck();
+    if (current.state == Playing)
+    {
+        int mixed = mixDeck(current, out, frames);
+        if (mixed < frames && current.decodeFinished && current.ring->available() == 0)
+        {
+            // Ran out; a queued song continues on the very next sample
+            Deck &next = otherDeck();
+            if (next.state == Ready)
+            {
+                startNext(false);
+                mixDeck(activeDeck(), out + mixed * Channels, frames - mixed);
+            }
+            else
+            {
+                stopDeck(current);
+                if (next.state == Loading)
+                {
+                    m_awaitingNext = true;
+                }
+                else
+                {
+                    emit trackFinished();
+                }
+            }
+        }
+    }
+
+    applyVolume(out, frames);
+
+    if (activeDeck().state == Playing)
+        m_position.store(activeDeck().playedFrames * 1000 / m_format.sampleRate(), std::memory_order_relaxed);
+    return qint64(frames) * FrameBytes;
+}
+
+qint64 AudioMixer::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void AudioMixer::publishDuration(const Deck &deck)
+{
+    qint64 duration = deck.totalFrames > 0 ? deck.totalFrames * 1000 / m_format.sampleRate() : 0;
+    m_duration.store(duration, std::memory_order_relaxed);
+    emit durationChanged(duration);
+}
+
+void AudioMixer::onDeckStarted(int index, int generation)
+{
+    Deck &deck = m_decks[index];
+    if (generation != deck.generation || deck.state != Loading)
+        return;
+
+    if (index == m_active)
+    {
+        deck.state = Playing;
+    }
+    else
+    {
+        deck.state = Ready;
+        if (m_awaitingNext)
+            startNext(false);
+    }
+}
+
+void AudioMixer::onDeckDuration(int index, qint64 durationMs, int generation)
+{
+    Deck &deck = m_decks[index];
+    if (generation != deck.generation || durationMs <= 0)
+        return;
+    deck.totalFrames = durationMs * m_format.sampleRate() / 1000;
+    if (index == m_active)
+        publishDuration(deck);
+}
+
+void AudioMixer::onDeckFinished(int index, int generation)
+{
+    Deck &deck = m_decks[index];
+    if (generation == deck.generation)
+        deck.decodeFinished = true;
+}
+
+void AudioMixer::onDeckError(int index, const QString &error, int generation)
+{
+    Deck &deck = m_decks[index];
+    if (generation != deck.generation)
+        return;
+    stopDeck(deck);
+    if (index == m_active)
+    {
+        emit errorOccurred(error);
+    }
+    else if (m_awaitingNext)
+    {
+        // The current song is over and the next one will not come
+        m_awaitingNext = false;
+        emit trackFinished();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include <QIODevice>
+#include <QUrl>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "AudioRingBuffer.hpp"
+
+class CachedStream;
+class QAudioSink;
+class TrackDecoder;
+
+// Pull-mode source of a QAudioSink that mixes two decks: the playing song
+// and the one queued after it. Runs on its own thread together with the
+// sink, so it only ever reads from the decks' lock-free rings and is not
+// held up by the GUI thread. A queued song starts on the sample the current
+// one runs out, or overlaps its tail with linear gain ramps when a
+// crossfade length is set. Control calls are queued onto the mixer thread.
+class AudioMixer : public QIODevice
+{
+    Q_OBJECT
+public:
+    static constexpr int Channels = 2;
+
+    AudioMixer(const QAudioDevice &device, const QAudioFormat &format, QObject *parent = nullptr);
+    ~AudioMixer();
+
+    AudioRingBuffer *ring(int deck) const { return m_decks[deck].ring.get(); }
+    void setDecoders(TrackDecoder *first, TrackDecoder *second);
+
+    // Safe from any thread
+    qint64 position() const { return m_position.load(std::memory_order_relaxed); }
+    qint64 duration() const { return m_duration.load(std::memory_order_relaxed); }
+    // Only the latest volume counts; the output ramps to it at a bounded
+    // rate, so a burst of knob steps becomes one click-free ramp
+    void setVolume(qreal volume);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+public slots:
+    void start();
+    void shutdown();
+    // A stream is handed on to the deck's decoder, see TrackDecoder::load()
+    void play(const QUrl &url, qreal trackGain, CachedStream *stream = nullptr);
+    void queueNext(const QUrl &url, int crossfadeMs, qreal trackGain, CachedStream *stream = nullptr);
+    void clearNext();
+    void pause();
+    void resume();
+    void stop();
+    // The byte offset only applies while url is still the playing song
+    void seek(qint64 positionMs, const QUrl &url = QUrl(), qint64 byteOffset = 0, qint64 byteOffsetMs = 0);
+
+signals:
+    // The queued song took over from the current one
+    void nextTrackStarted();
+    // The current song ran out with nothing queued
+    void trackFinished();
+    void durationChanged(qint64 duration);
+    void errorOccurred(const QString &error);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    enum DeckState
+    {
+        Idle,
+        Loading, // waiting for the decoder to reset the ring
+        Ready,   // queued, decoding ahead
+        Playing
+    };
+
+    struct Deck
+    {
+        std::unique_ptr<AudioRingBuffer> ring;
+        TrackDecoder *decoder = nullptr;
+        QUrl url;
+        int generation = 0;
+        DeckState state = Idle;
+        bool decodeFinished = false;
+        bool fadingOut = false;
+        qint64 playedFrames = 0;
+        qint64 totalFrames = -1;
+        float trackGain = 1.0f;
+        float gain = 1.0f;
+        float gainStep = 0.0f;
+        float targetGain = 1.0f;
+        qint64 rampFrames = 0;
+    };
+
+    Deck &activeDeck() { return m_decks[m_active]; }
+    Deck &otherDeck() { return m_decks[1 - m_active]; }
+    void loadDeck(Deck &deck, const QUrl &url, qint64 startMs, qint64 byteOffset = 0, qint64 byteOffsetMs = 0,
+                  CachedStream *stream = nullptr);
+    void stopDeck(Deck &deck);
+    void startNext(bool crossfade);
+    qint64 remainingFrames(const Deck &deck) const;
+    int mixDeck(Deck &deck, float *out, int frames);
+    void publishDuration(const Deck &deck);
+    void applyVolume(float *out, int frames);
+
+    void onDeckStarted(int index, int generation);
+    void onDeckDuration(int index, qint64 durationMs, int generation);
+    void onDeckFinished(int index, int generation);
+    void onDeckError(int index, const QString &error, int generation);
+
+    QAudioDevice m_device;
+    QAudioFormat m_format;
+    QAudioSink *m_sink = nullptr;
+    Deck m_decks[2];
+    int m_active = 0;
+    qint64 m_fadeFrames = 0;
+    // The current song ran out while the next one was still loading
+    bool m_awaitingNext = false;
+    std::vector<float> m_scratch;
+    std::atomic<qint64> m_position{0};
+    std::atomic<qint64> m_duration{0};
+    std::atomic<float> m_targetVolume{1.0f};
+    float m_volume = 1.0f;
+    float m_volumeRampTarget = 1.0f;
+    float m_volumeStep = 0.0f;
+    qint64 m_volumeRampFrames = 0;
+};
\ No newline at end of file
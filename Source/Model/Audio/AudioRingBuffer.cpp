@@ -0,0 +1,51 @@
+#include "AudioRingBuffer.hpp"
+#include <algorithm>
+
+AudioRingBuffer::AudioRingBuffer(int capacity)
+{
+    quint64 size = 1;
+    while (size < quint64(qMax(capacity, 1)))
+        size <<= 1;
+    m_samples.resize(size);
+    m_mask = size - 1;
+}
+
+int AudioRingBuffer::write(const float *samples, int count)
+{
+    quint64 writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+    quint64 readIndex = m_readIndex.load(std::memory_order_acquire);
+    int n = int(qMin<quint64>(quint64(qMax(count, 0)), m_samples.size() - (writeIndex - readIndex)));
+
+    quint64 start = writeIndex & m_mask;
+    int first = int(qMin<quint64>(quint64(n), m_samples.size() - start));
+    std::copy_n(samples, first, m_samples.data() + start);
+    std::copy_n(samples + first, n - first, m_samples.data());
+    m_writeIndex.store(writeIndex + n, std::memory_order_release);
+    return n;
+}
+
+int AudioRingBuffer::read(float *samples, int count)
+{
+    quint64 readIndex = m_readIndex.load(std::memory_order_relaxed);
+    quint64 writeIndex = m_writeIndex.load(std::memory_order_acquire);
+    int n = int(qMin<quint64>(quint64(qMax(count, 0)), writeIndex - readIndex));
+
+    quint64 start = readIndex & m_mask;
+    int first = int(qMin<quint64>(quint64(n), m_samples.size() - start));
+    std::copy_n(m_samples.data() + start, first, samples);
+    std::copy_n(m_samples.data(), n - first, samples + first);
+    m_readIndex.store(readIndex + n, std::memory_order_release);
+    return n;
+}
+
+int AudioRingBuffer::available() const
+{
+    quint64 readIndex = m_readIndex.load(std::memory_order_acquire);
+    return int(m_writeIndex.load(std::memory_order_acquire) - readIndex);
+}
+
+void AudioRingBuffer::reset()
+{
+    m_readIndex.store(0, std::memory_order_relaxed);
+    m_writeIndex.store(0, std::memory_order_release);
+}
\ No newline at end of file
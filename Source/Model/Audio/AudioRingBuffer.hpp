@@ -0,0 +1,29 @@
+#pragma once
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// Single-producer single-consumer ring of interleaved float samples. One
+// thread writes and another reads without locking; the indices only grow
+// and the capacity is a power of two, so wrapping is a mask.
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(int capacity);
+
+    // Producer side; returns the number of samples written
+    int write(const float *samples, int count);
+    // Consumer side; returns the number of samples read
+    int read(float *samples, int count);
+    int available() const;
+    int space() const { return capacity() - available(); }
+    int capacity() const { return int(m_samples.size()); }
+    // Only while neither side is reading or writing
+    void reset();
+
+private:
+    std::vector<float> m_samples;
+    quint64 m_mask;
+    std::atomic<quint64> m_readIndex{0};
+    std::atomic<quint64> m_writeIndex{0};
+};
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "Fft.hpp"
+#include <cmath>
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+}
+
+Fft::Fft(int size)
+    : m_size(size)
+{
+    const int half = size / 2;
+    m_twiddles.resize(half / 2);
+    for (int i = 0; i < half / 2; ++i)
+        m_twiddles[i] = std::polar(1.0f, float(-2.0 * Pi * i / half));
+    m_splitTwiddles.resize(half);
+    for (int k = 0; k < half; ++k)
+        m_splitTwiddles[k] = std::polar(1.0f, float(-2.0 * Pi * k / size));
+
+    int bits = 0;
+    while ((1 << bits) < half)
+        ++bits;
+    m_reversed.resize(half);
+    for (int i = 0; i < half; ++i)
+    {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; ++bit)
+            reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+        m_reversed[i] = reversed;
+    }
+    m_buffer.resize(half);
+}
+
+void Fft::powerSpectrum(const float *samples, float *power)
+{
+    const int half = m_size / 2;
+    std::complex<float> *z = m_buffer.data();
+
+    // Even samples are the real part and odd samples the imaginary part
+    for (int i = 0; i < half; ++i)
+        z[m_reversed[i]] = std::complex<float>(samples[2 * i], samples[2 * i + 1]);
+
+    // Iterative radix-2 decimation in time
+    for (int length = 2; length <= half; length <<= 1)
+    {
+        const int stride = half / length;
+        const int span = length / 2;
+        for (int start = 0; start < half; start += length)
+        {
+            for (int j = 0; j < span; ++j)
+            {
+                std::complex<float> odd = z[start + j + span] * m_twiddles[j * stride];
+                z[start + j + span] = z[start + j] - odd;
+                z[start + j] += odd;
+            }
+        }
+    }
+
+    // Split the packed transform back into the spectrum of the real block
+    for (int k = 0; k < half; ++k)
+    {
+        std::complex<float> a = z[k];
+        std::complex<float> b = std::conj(z[k == 0 ? 0 : half - k]);
+        std::complex<float> even = 0.5f * (a + b);
+        std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (a - b);
+        std::complex<float> bin = even + m_splitTwiddles[k] * odd;
+        power[k] = std::norm(bin);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <complex>
+#include <vector>
+
+// Power spectrum of a block of real samples. The block is packed into a
+// complex FFT of half its size and split afterwards, so twiddles and the
+// bit-reversal order are computed once and a transform allocates nothing.
+class Fft
+{
+public:
+    // size must be a power of two
+    explicit Fft(int size);
+
+    int size() const { return m_size; }
+    // power receives size / 2 bins, from DC up to just below Nyquist
+    void powerSpectrum(const float *samples, float *power);
+
+private:
+    int m_size;
+    std::vector<std::complex<float>> m_twiddles;
+    std::vector<std::complex<float>> m_splitTwiddles;
+    std::vector<int> m_reversed;
+    std::vector<std::complex<float>> m_buffer;
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "LoudnessAnalyzer.hpp"
+#include "LoudnessMeter.hpp"
+#include "LoudnessStore.hpp"
+#include "AudioFileDecoder.hpp"
+#include "StreamCache.hpp"
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <memory>
+
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowestPriority);
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &LoudnessAnalyzer::onAnalysisFinished);
+
+    StreamCache *cache = StreamCache::instance();
+    connect(cache, &StreamCache::songCached, this, &LoudnessAnalyzer::enqueue);
+    for (int songId : cache->completeSongIds())
+        enqueue(songId);
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    // The running song is dropped unrecorded and measured again next time
+    m_cancelled = true;
+    m_pool.waitForDone();
+}
+
+void LoudnessAnalyzer::setPaused(bool paused)
+{
+    m_paused = paused;
+}
+
+void LoudnessAnalyzer::enqueue(int songId)
+{
+    if (m_queued.contains(songId) || songId == m_current || LoudnessStore::instance().contains(songId))
+        return;
+    m_queued.insert(songId);
+    m_queue.append(songId);
+    startNext();
+}
+
+void LoudnessAnalyzer::startNext()
+{
+    while (m_current == -1 && !m_queue.isEmpty())
+    {
+        int songId = m_queue.takeFirst();
+        m_queued.remove(songId);
+        // Evicted since it was queued; it comes back if it is cached again
+        QString filePath = StreamCache::instance()->localFile(songId);
+        if (filePath.isEmpty() || LoudnessStore::instance().contains(songId))
+            continue;
+        m_current = songId;
+        m_watcher.setFuture(QtConcurrent::run(&m_pool, &LoudnessAnalyzer::analyze, filePath, &m_paused, &m_cancelled));
+    }
+}
+
+void LoudnessAnalyzer::onAnalysisFinished()
+{
+    int songId = m_current;
+    m_current = -1;
+    Result result = m_watcher.result();
+    if (result.complete)
+    {
+        LoudnessStore::instance().insert(songId, result.loudness, result.peak);
+        qDebug() << "LoudnessAnalyzer: Song" << songId << "loudness" << result.loudness << "LUFS, peak" << result.peak;
+        emit songAnalyzed(songId);
+    }
+    startNext();
+}
+
+LoudnessAnalyzer::Result LoudnessAnalyzer::analyze(const QString &filePath, const std::atomic<bool> *paused, const std::atomic<bool> *cancelled)
+{
+    Result result{qQNaN(), 0.0f, true};
+    std::unique_ptr<LoudnessMeter> meter;
+    auto consume = [&meter](const float *samples, int frames, int sampleRate)
+    {
+        if (!meter)
+            meter = std::make_unique<LoudnessMeter>(sampleRate);
+        meter->process(samples, frames);
+    };
+
+    AudioFileDecoder::Result decoded = AudioFileDecoder::decode(filePath, consume, cancelled, paused);
+    if (decoded == AudioFileDecoder::Cancelled)
+    {
+        result.complete = false;
+    }
+    else if (decoded == AudioFileDecoder::Finished && meter)
+    {
+        result.loudness = meter->integratedLoudness();
+        result.peak = meter->peak();
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <atomic>
+
+// Measures the loudness of fully cached songs in the background, one song at
+// a time on a single lowest-priority thread, and records it in the
+// LoudnessStore. Songs are picked up as the StreamCache completes them and,
+// at startup, from what is cached but not yet measured, so analysis cut short
+// by quitting resumes on the next run.
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    // While paused the analysis stops reading decoded audio, which also stalls its decoder
+    void setPaused(bool paused);
+
+signals:
+    void songAnalyzed(int songId);
+
+private slots:
+    void enqueue(int songId);
+    void onAnalysisFinished();
+
+private:
+    struct Result
+    {
+        double loudness;
+        float peak;
+        bool complete;
+    };
+
+    static Result analyze(const QString &filePath, const std::atomic<bool> *paused, const std::atomic<bool> *cancelled);
+    void startNext();
+
+    QList<int> m_queue;
+    QSet<int> m_queued;
+    int m_current = -1;
+    QThreadPool m_pool;
+    QFutureWatcher<Result> m_watcher;
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_cancelled{false};
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "LoudnessMeter.hpp"
+#include <QtMath>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOUDNESS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LOUDNESS_NEON
+#endif
+
+namespace
+{
+    constexpr int HopMs = 100;
+    constexpr int HopsPerBlock = 4;
+    constexpr double AbsoluteGateLufs = -70.0;
+    constexpr double RelativeGateLu = -10.0;
+
+    double toLufs(double meanSquare)
+    {
+        return -0.691 + 10.0 * std::log10(meanSquare);
+    }
+
+    double fromLufs(double lufs)
+    {
+        return std::pow(10.0, (lufs + 0.691) / 10.0);
+    }
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate)
+    : m_hopFrames(qMax(sampleRate * HopMs / 1000, 1))
+{
+    // K-weighting for any sample rate, from the analogue prototypes of BS.1770:
+    // a high shelf for the head, then the RLB high-pass
+    double K = std::tan(M_PI * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    double Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = std::pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    m_stages[0] = {(Vh + Vb * K / Q + K * K) / a0, 2.0 * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0,
+                   2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0};
+
+    K = std::tan(M_PI * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    m_stages[1] = {1.0, -2.0, 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0};
+}
+
+void LoudnessMeter::process(const float *samples, int frames)
+{
+    while (frames > 0)
+    {
+        int count = qMin(frames, m_hopFrames - m_hopPosition);
+        m_hopEnergy += filter(samples, count);
+        m_hopPosition += count;
+        samples += count * 2;
+        frames -= count;
+        if (m_hopPosition == m_hopFrames)
+            endHop();
+    }
+}
+
+double LoudnessMeter::filter(const float *samples, int frames)
+{
+    double energy = 0.0;
+    float peak = m_peak;
+#if defined(LOUDNESS_SSE2)
+    __m128d b0[2], b1[2], b2[2], a1[2], a2[2], z1[2], z2[2];
+    for (int s = 0; s < 2; ++s)
+    {
+        b0[s] = _mm_set1_pd(m_stages[s].b0);
+        b1[s] = _mm_set1_pd(m_stages[s].b1);
+        b2[s] = _mm_set1_pd(m_stages[s].b2);
+        a1[s] = _mm_set1_pd(m_stages[s].a1);
+        a2[s] = _mm_set1_pd(m_stages[s].a2);
+        z1[s] = _mm_loadu_pd(m_state[s][0]);
+        z2[s] = _mm_loadu_pd(m_state[s][1]);
+    }
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d sum = _mm_setzero_pd();
+    __m128d peaks = _mm_set1_pd(peak);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        __m128d x = _mm_setr_pd(samples[frame * 2], samples[frame * 2 + 1]);
+        peaks = _mm_max_pd(peaks, _mm_andnot_pd(signMask, x));
+        for (int s = 0; s < 2; ++s)
+        {
+            __m128d y = _mm_add_pd(_mm_mul_pd(b0[s], x), z1[s]);
+            z1[s] = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1[s], x), _mm_mul_pd(a1[s], y)), z2[s]);
+            z2[s] = _mm_sub_pd(_mm_mul_pd(b2[s], x), _mm_mul_pd(a2[s], y));
+            x = y;
+        }
+        sum = _mm_add_pd(sum, _mm_mul_pd(x, x));
+    }
+    for (int s = 0; s < 2; ++s)
+    {
+        _mm_storeu_pd(m_state[s][0], z1[s]);
+        _mm_storeu_pd(m_state[s][1], z2[s]);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    energy = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, peaks);
+    peak = float(qMax(lanes[0], lanes[1]));
+#elif defined(LOUDNESS_NEON)
+    float64x2_t b0[2], b1[2], b2[2], a1[2], a2[2], z1[2], z2[2];
+    for (int s = 0; s < 2; ++s)
+    {
+        b0[s] = vdupq_n_f64(m_stages[s].b0);
+        b1[s] = vdupq_n_f64(m_stages[s].b1);
+        b2[s] = vdupq_n_f64(m_stages[s].b2);
+        a1[s] = vdupq_n_f64(m_stages[s].a1);
+        a2[s] = vdupq_n_f64(m_stages[s].a2);
+        z1[s] = vld1q_f64(m_state[s][0]);
+        z2[s] = vld1q_f64(m_state[s][1]);
+    }
+    float64x2_t sum = vdupq_n_f64(0.0);
+    float64x2_t peaks = vdupq_n_f64(peak);
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        float64x2_t x = vcvt_f64_f32(vld1_f32(samples + frame * 2));
+        peaks = vmaxq_f64(peaks, vabsq_f64(x));
+        for (int s = 0; s < 2; ++s)
+        {
+            float64x2_t y = vfmaq_f64(z1[s], b0[s], x);
+            z1[s] = vaddq_f64(vfmsq_f64(vmulq_f64(b1[s], x), a1[s], y), z2[s]);
+            z2[s] = vfmsq_f64(vmulq_f64(b2[s], x), a2[s], y);
+            x = y;
+        }
+        sum = vfmaq_f64(sum, x, x);
+    }
+    for (int s = 0; s < 2; ++s)
+    {
+        vst1q_f64(m_state[s][0], z1[s]);
+        vst1q_f64(m_state[s][1], z2[s]);
+    }
+    energy = vaddvq_f64(sum);
+    peak = float(vmaxvq_f64(peaks));
+#else
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            double x = samples[frame * 2 + channel];
+            peak = qMax(peak, float(std::fabs(x)));
+            for (int s = 0; s < 2; ++s)
+            {
+                const Biquad &q = m_stages[s];
+                double y = q.b0 * x + m_state[s][0][channel];
+                m_state[s][0][channel] = q.b1 * x - q.a1 * y + m_state[s][1][channel];
+                m_state[s][1][channel] = q.b2 * x - q.a2 * y;
+                x = y;
+            }
+            energy += x * x;
+        }
+    }
+#endif
+    m_peak = peak;
+    return energy;
+}
+
+void LoudnessMeter::endHop()
+{
+    m_recentHops[m_hopCount % HopsPerBlock] = m_hopEnergy;
+    m_hopEnergy = 0.0;
+    m_hopPosition = 0;
+    if (++m_hopCount < HopsPerBlock)
+        return;
+
+    double energy = 0.0;
+    for (double hop : m_recentHops)
+        energy += hop;
+    m_blocks.append(energy / (double(m_hopFrames) * HopsPerBlock));
+}
+
+double LoudnessMeter::integratedLoudness() const
+{
+    const double absoluteGate = fromLufs(AbsoluteGateLufs);
+    double sum = 0.0;
+    int count = 0;
+    for (double block : m_blocks)
+    {
+        if (block > absoluteGate)
+        {
+            sum += block;
+            ++count;
+        }
+    }
+    if (count == 0)
+        return qQNaN();
+
+    const double relativeGate = qMax(sum / count * std::pow(10.0, RelativeGateLu / 10.0), absoluteGate);
+    sum = 0.0;
+    count = 0;
+    for (double block : m_blocks)
+    {
+        if (block > relativeGate)
+        {
+            sum += block;
+            ++count;
+        }
+    }
+    return count > 0 ? toLufs(sum / count) : qQNaN();
+}
\ No newline at end of file
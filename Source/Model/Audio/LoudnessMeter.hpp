@@ -0,0 +1,39 @@
+#pragma once
+#include <QList>
+
+// Integrated loudness of interleaved stereo audio per ITU-R BS.1770 / EBU
+// R128: K-weighting, 400 ms blocks every 100 ms, then the absolute -70 LUFS
+// and relative -10 LU gates. Fed incrementally, so a song never has to be
+// held in memory. Both channels run through the filters side by side in one
+// SSE2 or NEON register of doubles.
+class LoudnessMeter
+{
+public:
+    explicit LoudnessMeter(int sampleRate);
+
+    void process(const float *samples, int frames);
+    // LUFS; NaN if no block rose above the absolute gate
+    double integratedLoudness() const;
+    float peak() const { return m_peak; }
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    double filter(const float *samples, int frames);
+    void endHop();
+
+    Biquad m_stages[2];
+    // Transposed direct form II state: [stage][z1, z2][left, right]
+    double m_state[2][2][2] = {};
+    int m_hopFrames;
+    int m_hopPosition = 0;
+    double m_hopEnergy = 0.0;
+    double m_recentHops[4] = {};
+    int m_hopCount = 0;
+    // Mean square of every 400 ms block, summed over channels
+    QList<double> m_blocks;
+    float m_peak = 0.0f;
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "LoudnessStore.hpp"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+namespace
+{
+    const quint32 StoreMagic = 0x4c4f5544; // "LOUD"
+    const quint32 StoreVersion = 1;
+    // Near-silent songs would otherwise be boosted into noise
+    const double MaxGainDb = 12.0;
+}
+
+LoudnessStore &LoudnessStore::instance()
+{
+    static LoudnessStore instance;
+    return instance;
+}
+
+LoudnessStore::LoudnessStore()
+    : m_path(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/loudness.dat")
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    load();
+}
+
+double LoudnessStore::gainDb(int songId) const
+{
+    auto it = m_entries.constFind(songId);
+    if (it == m_entries.constEnd() || qIsNaN(it->loudness))
+        return 0.0;
+
+    double gain = ReferenceLufs - it->loudness;
+    if (it->peak > 0.0f)
+        gain = qMin(gain, -20.0 * std::log10(double(it->peak)));
+    return qMin(gain, MaxGainDb);
+}
+
+void LoudnessStore::insert(int songId, double loudness, float peak)
+{
+    m_entries.insert(songId, {loudness, peak});
+    save();
+}
+
+void LoudnessStore::load()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != StoreMagic || version != StoreVersion || count < 0)
+        return;
+
+    m_entries.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        qint32 songId = 0;
+        Entry entry;
+        in >> songId >> entry.loudness >> entry.peak;
+        if (in.status() == QDataStream::Ok)
+            m_entries.insert(songId, entry);
+    }
+    qDebug() << "LoudnessStore: Loaded loudness of" << m_entries.size() << "songs";
+}
+
+void LoudnessStore::save() const
+{
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << StoreMagic << StoreVersion << qint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        out << qint32(it.key()) << it->loudness << it->peak;
+    file.commit();
+}
\ No newline at end of file
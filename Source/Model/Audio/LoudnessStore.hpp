@@ -0,0 +1,36 @@
+#pragma once
+#include <QHash>
+#include <QString>
+
+// Measured loudness and peak of every analysed song, persisted in a small
+// binary file so analysis survives restarts. Gains are derived on read, so
+// changing the reference level needs no new analysis.
+// Must only be used from the GUI thread.
+class LoudnessStore
+{
+public:
+    static constexpr double ReferenceLufs = -18.0; // ReplayGain 2.0
+
+    static LoudnessStore &instance();
+
+    bool contains(int songId) const { return m_entries.contains(songId); }
+    // Gain that brings the song to the reference level without clipping its
+    // peak; 0 dB for songs that are not analysed or could not be
+    double gainDb(int songId) const;
+    // loudness is NaN for songs that could not be analysed; they are not retried
+    void insert(int songId, double loudness, float peak);
+
+private:
+    struct Entry
+    {
+        double loudness;
+        float peak;
+    };
+
+    LoudnessStore();
+    void load();
+    void save() const;
+
+    QString m_path;
+    QHash<int, Entry> m_entries;
+};
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "SpectrumAnalyzer.hpp"
+#include <QAudioBufferOutput>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QThread>
+#include <QTimer>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+    // 23 Hz bins at 48 kHz, fine enough to split the bass into bands
+    constexpr int FftSize = 2048;
+    // Mono samples; about 170 ms at 48 kHz before the producer drops audio
+    constexpr int RingCapacity = 8192;
+    constexpr double LowestBandHz = 40.0;
+    constexpr double HighestBandHz = 16000.0;
+    // Band power shown from -60 dB below a full-scale sine up to full scale
+    constexpr float FloorDb = -60.0f;
+    // Time a band takes to fall from full to silent
+    constexpr float FallMs = 500.0f;
+    constexpr qreal DefaultRefreshRate = 60.0;
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(QObject *parent)
+    : QObject(parent), m_tap(nullptr), m_thread(new QThread(this)), m_timer(new QTimer()),
+      m_ring(RingCapacity), m_fft(FftSize)
+{
+    QAudioFormat format;
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Float);
+    m_tap = new QAudioBufferOutput(format, this);
+    // Direct, so the GUI thread never touches the samples
+    connect(m_tap, &QAudioBufferOutput::audioBufferReceived, m_tap, [this](const QAudioBuffer &buffer)
+            { feed(buffer); }, Qt::DirectConnection);
+
+    m_window.resize(FftSize);
+    for (int i = 0; i < FftSize; ++i)
+        m_window[i] = float(0.5 - 0.5 * std::cos(2.0 * M_PI * i / (FftSize - 1)));
+    m_block.assign(FftSize, 0.0f);
+    m_windowed.resize(FftSize);
+    m_power.resize(FftSize / 2);
+    for (std::atomic<float> &band : m_bands)
+        band.store(0.0f, std::memory_order_relaxed);
+
+    qreal refreshRate = DefaultRefreshRate;
+    if (QScreen *screen = QGuiApplication::primaryScreen())
+        refreshRate = qMax<qreal>(screen->refreshRate(), 1.0);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    m_timer->moveToThread(m_thread);
+    connect(m_timer, &QTimer::timeout, m_timer, [this]()
+            { analyze(); });
+    connect(m_thread, &QThread::finished, m_timer, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void SpectrumAnalyzer::setActive(bool active)
+{
+    if (m_active == active)
+        return;
+    m_active = active;
+    m_running.store(active, std::memory_order_release);
+    if (active)
+    {
+        QTimer *timer = m_timer;
+        QMetaObject::invokeMethod(timer, [timer]()
+                                  { timer->start(); });
+    }
+    emit activeChanged();
+}
+
+void SpectrumAnalyzer::bands(float *levels) const
+{
+    for (int i = 0; i < BandCount; ++i)
+        levels[i] = m_bands[i].load(std::memory_order_relaxed);
+}
+
+void SpectrumAnalyzer::feed(const QAudioBuffer &buffer)
+{
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const int frames = int(buffer.frameCount());
+    if (frames <= 0 || channels <= 0)
+        return;
+    m_sampleRate.store(format.sampleRate(), std::memory_order_relaxed);
+
+    if (format.sampleFormat() == QAudioFormat::Float && channels == 1)
+    {
+        m_ring.write(buffer.constData<float>(), frames);
+        return;
+    }
+
+    // Backends that ignore the requested format
+    m_mono.resize(frames);
+    const char *data = buffer.constData<char>();
+    const int bytesPerSample = format.bytesPerSample();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const char *sample = data + frame * channels * bytesPerSample;
+        float sum = 0.0f;
+        for (int channel = 0; channel < channels; ++channel)
+            sum += format.normalizedSampleValue(sample + channel * bytesPerSample);
+        m_mono[frame] = sum / channels;
+    }
+    m_ring.write(m_mono.data(), frames);
+}
+
+void SpectrumAnalyzer::analyze()
+{
+    const float fall = float(m_timer->interval()) / FallMs;
+    const int sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+    if (sampleRate > 0 && sampleRate != m_bandSampleRate)
+        updateBandEdges(sampleRate);
+
+    // Only the newest block matters; anything older is dropped unread
+    const int fresh = qMin(m_ring.available(), FftSize);
+    while (m_ring.available() > fresh)
+        m_ring.read(m_windowed.data(), qMin(m_ring.available() - fresh, FftSize));
+
+    std::array<float, BandCount> measured{};
+    if (fresh > 0 && m_bandSampleRate > 0)
+    {
+        std::move(m_block.begin() + fresh, m_block.end(), m_block.begin());
+        m_ring.read(m_block.data() + FftSize - fresh, fresh);
+        for (int i = 0; i < FftSize; ++i)
+            m_windowed[i] = m_block[i] * m_window[i];
+        m_fft.powerSpectrum(m_windowed.data(), m_power.data());
+
+        // A full-scale sine peaks at (N / 4)^2 through the Hann window
+        const float reference = float(FftSize / 4) * float(FftSize / 4);
+        for (int band = 0; band < BandCount; ++band)
+        {
+            if (m_bandEdges[band] >= m_bandEdges[band + 1])
+                continue;
+            float peak = *std::max_element(m_power.begin() + m_bandEdges[band], m_power.begin() + m_bandEdges[band + 1]);
+            float db = 10.0f * std::log10(qMax(peak / reference, 1e-12f));
+            measured[band] = qBound(0.0f, 1.0f - db / FloorDb, 1.0f);
+        }
+    }
+
+    // Bars jump up at once and fall back at a fixed rate
+    bool silent = true;
+    for (int band = 0; band < BandCount; ++band)
+    {
+        m_levels[band] = qMax(measured[band], m_levels[band] - fall);
+        m_bands[band].store(m_levels[band], std::memory_order_relaxed);
+        silent = silent && m_levels[band] <= 0.0f;
+    }
+
+    if (silent && !m_running.load(std::memory_order_acquire))
+    {
+        m_timer->stop();
+        std::fill(m_block.begin(), m_block.end(), 0.0f);
+    }
+}
+
+void SpectrumAnalyzer::updateBandEdges(int sampleRate)
+{
+    m_bandSampleRate = sampleRate;
+    const double binHz = double(sampleRate) / FftSize;
+    const double highest = qMin(HighestBandHz, sampleRate / 2.0);
+    const int bins = FftSize / 2;
+    for (int edge = 0; edge <= BandCount; ++edge)
+    {
+        double hz = LowestBandHz * std::pow(highest / LowestBandHz, double(edge) / BandCount);
+        m_bandEdges[edge] = qBound(1, int(std::lround(hz / binHz)), bins);
+    }
+    // Low bands narrower than a bin still get one bin each
+    for (int edge = 1; edge <= BandCount; ++edge)
+        m_bandEdges[edge] = qMax(m_bandEdges[edge], m_bandEdges[edge - 1] + 1);
+    for (int edge = 0; edge <= BandCount; ++edge)
+        m_bandEdges[edge] = qMin(m_bandEdges[edge], bins);
+    qDebug() << "SpectrumAnalyzer: Bands for" << sampleRate << "Hz";
+}
\ No newline at end of file
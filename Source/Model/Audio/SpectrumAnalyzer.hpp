@@ -0,0 +1,68 @@
+#pragma once
+#include <QObject>
+#include <QAudioBuffer>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "AudioRingBuffer.hpp"
+#include "Fft.hpp"
+
+class QAudioBufferOutput;
+class QThread;
+class QTimer;
+
+// Band levels of what is playing, for a visualizer. The player's tap
+// downmixes decoded audio into a lock-free ring, and an analysis thread
+// transforms the latest block once per display frame and reduces it to a
+// few log-spaced bands. Readers only ever see that small array.
+class SpectrumAnalyzer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int bandCount READ bandCount CONSTANT)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+
+public:
+    static constexpr int BandCount = 32;
+
+    explicit SpectrumAnalyzer(QObject *parent = nullptr);
+    ~SpectrumAnalyzer();
+
+    // Set on the player that is playing; only one player at a time
+    QAudioBufferOutput *tap() const { return m_tap; }
+    int bandCount() const { return BandCount; }
+    bool isActive() const { return m_active; }
+    // Bands fall back to silence after playback stops
+    void setActive(bool active);
+    // From any thread; levels from 0 to 1, BandCount of them
+    void bands(float *levels) const;
+
+signals:
+    void activeChanged();
+
+private:
+    // Called on whichever thread the player delivers buffers from
+    void feed(const QAudioBuffer &buffer);
+    // Analysis thread
+    void analyze();
+    void updateBandEdges(int sampleRate);
+
+    QAudioBufferOutput *m_tap;
+    QThread *m_thread;
+    QTimer *m_timer;
+    bool m_active = false;
+    // m_active as seen by the analysis thread
+    std::atomic<bool> m_running{false};
+    AudioRingBuffer m_ring;
+    std::atomic<int> m_sampleRate{0};
+    std::vector<float> m_mono;
+
+    Fft m_fft;
+    int m_bandSampleRate = 0;
+    std::vector<float> m_window;
+    std::vector<float> m_block;
+    std::vector<float> m_windowed;
+    std::vector<float> m_power;
+    std::array<int, BandCount + 1> m_bandEdges{};
+    std::array<float, BandCount> m_levels{};
+    std::array<std::atomic<float>, BandCount> m_bands{};
+};
\ No newline at end of file
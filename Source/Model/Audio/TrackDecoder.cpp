@@ -0,0 +1,308 @@
+#include "TrackDecoder.hpp"
+#include "AudioRingBuffer.hpp"
+#include "CachedStream.hpp"
+#include "HttpClient.hpp"
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QDebug>
+#include <cstring>
+
+namespace
+{
+    constexpr int Channels = 2;
+    constexpr int PumpIntervalMs = 10;
+
+    // The part of a seekable source from offset on, as a device of its own.
+    // The demuxer seeks to absolute positions, e.g. to probe the tail for
+    // tags or to go back after it; those must land inside the window rather
+    // than near the start of the song.
+    class ByteWindow : public QIODevice
+    {
+    public:
+        ByteWindow(QIODevice *source, qint64 offset, QObject *parent)
+            : QIODevice(parent), m_source(source), m_offset(offset)
+        {
+            connect(source, &QIODevice::readyRead, this, &QIODevice::readyRead);
+            m_source->seek(offset);
+            open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        }
+
+        bool isSequential() const override { return false; }
+        qint64 size() const override { return qMax<qint64>(m_source->size() - m_offset, 0); }
+        bool seek(qint64 pos) override { return m_source->seek(m_offset + pos) && QIODevice::seek(pos); }
+        bool atEnd() const override { return m_source->atEnd(); }
+        qint64 bytesAvailable() const override { return m_source->bytesAvailable(); }
+
+    protected:
+        qint64 readData(char *data, qint64 maxSize) override { return m_source->read(data, maxSize); }
+        qint64 writeData(const char *, qint64) override { return -1; }
+
+    private:
+        QIODevice *m_source;
+        qint64 m_offset;
+    };
+}
+
+TrackDecoder::TrackDecoder(AudioRingBuffer *ring, const QAudioFormat &format, QObject *parent)
+    : QObject(parent), m_ring(ring), m_format(format), m_pumpTimer(new QTimer(this))
+{
+    // Polls for ring space while the mixer drains it
+    m_pumpTimer->setInterval(PumpIntervalMs);
+    connect(m_pumpTimer, &QTimer::timeout, this, &TrackDecoder::pump);
+}
+
+TrackDecoder::~TrackDecoder()
+{
+    // The decoder lets go of the stream before either is deleted
+    stop(m_generation);
+}
+
+void TrackDecoder::load(const QUrl &url, qint64 startMs, int generation, qint64 byteOffset, qint64 byteOffsetMs,
+                        CachedStream *stream)
+{
+    // Created here rather than in the constructor so it lives on the worker thread
+    if (!m_decoder)
+    {
+        m_decoder = new QAudioDecoder(this);
+        m_decoder->setAudioFormat(m_format);
+        connect(m_decoder, &QAudioDecoder::bufferReady, this, &TrackDecoder::pump);
+        connect(m_decoder, &QAudioDecoder::finished, this, &TrackDecoder::onDecoderFinished);
+        connect(m_decoder, &QAudioDecoder::error, this, &TrackDecoder::onDecoderError);
+        connect(m_decoder, &QAudioDecoder::durationChanged, this, [this](qint64 duration)
+                {
+            if (m_reportDuration)
+                emit durationChanged(duration, m_generation); });
+    }
+
+    stop(generation);
+    m_ring->reset();
+    if (stream || url != m_streamUrl)
+    {
+        // Another song; the reader of the previous one is done
+        if (m_stream)
+            m_stream->deleteLater();
+        m_stream = stream;
+        m_streamUrl = stream ? url : QUrl();
+        if (m_stream)
+            m_stream->setParent(this);
+    }
+
+    // An offset the fill has not reached yet is fetched on its own
+    if (m_stream && byteOffset > 0 && m_stream->isCached(byteOffset))
+    {
+        m_stream->setInterrupted(false);
+        m_source = new ByteWindow(m_stream, byteOffset, this);
+        begin(url, m_source, startMs, byteOffsetMs);
+    }
+    else if (byteOffset > 0 && (m_source = openAt(url, byteOffset)))
+    {
+        QNetworkReply *reply = qobject_cast<QNetworkReply *>(m_source);
+        if (!reply)
+        {
+            begin(url, m_source, startMs, byteOffsetMs);
+        }
+        else
+        {
+            // Only a 206 body starts at the offset; a server that ignores the
+            // range sends the whole song, which is decoded from the start
+            auto onResponse = [this, reply, url, startMs, byteOffsetMs, generation]()
+            {
+                if (m_source != reply || m_decoding || generation != m_generation)
+                    return;
+                int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                if (status == 206)
+                {
+                    begin(url, reply, startMs, byteOffsetMs);
+                    return;
+                }
+                qDebug() << "TrackDecoder: Ranged request answered with" << status << ", decoding from the start";
+                m_source = nullptr;
+                reply->abort();
+                reply->deleteLater();
+                begin(url, wholeStream(), startMs, 0);
+            };
+            connect(reply, &QNetworkReply::metaDataChanged, this, onResponse);
+            connect(reply, &QNetworkReply::finished, this, onResponse);
+        }
+    }
+    else
+    {
+        begin(url, wholeStream(), startMs, 0);
+    }
+    emit started(generation);
+}
+
+QIODevice *TrackDecoder::wholeStream()
+{
+    if (m_stream)
+    {
+        m_stream->setInterrupted(false);
+        m_stream->seek(0);
+    }
+    return m_stream;
+}
+
+void TrackDecoder::begin(const QUrl &url, QIODevice *device, qint64 startMs, qint64 byteOffsetMs)
+{
+    // A device that starts after the first frame covers only the rest of the song
+    m_reportDuration = byteOffsetMs == 0;
+    m_skipSamples = qMax<qint64>(startMs - byteOffsetMs, 0) * m_format.sampleRate() / 1000 * Channels;
+    m_decoding = true;
+    if (device)
+        m_decoder->setSourceDevice(device);
+    else
+        m_decoder->setSource(url);
+    m_decoder->start();
+}
+
+void TrackDecoder::stop(int generation)
+{
+    m_generation = generation;
+    m_pumpTimer->stop();
+    m_pending.clear();
+    m_pendingOffset = 0;
+    m_decoding = false;
+    m_decoderDone = false;
+    // A read waiting for the fill would hold up the decoder's stop
+    if (m_stream)
+        m_stream->setInterrupted(true);
+    if (m_decoder)
+        m_decoder->stop();
+    if (m_decoder && (m_source || m_stream))
+        m_decoder->setSourceDevice(nullptr);
+    if (m_source)
+    {
+        m_source->deleteLater();
+        m_source = nullptr;
+    }
+}
+
+QIODevice *TrackDecoder::openAt(const QUrl &url, qint64 byteOffset)
+{
+    if (url.isLocalFile())
+    {
+        QFile *file = new QFile(url.toLocalFile(), this);
+        if (!file->open(QIODevice::ReadOnly) || file->size() <= byteOffset)
+        {
+            delete file;
+            return nullptr;
+        }
+        ByteWindow *window = new ByteWindow(file, byteOffset, this);
+        file->setParent(window);
+        return window;
+    }
+
+    // Replies belong to the thread that made them, so this thread gets its
+    // own manager; the request still carries the shared client's headers
+    if (!m_network)
+        m_network = new QNetworkAccessManager(this);
+    QNetworkRequest request = HttpClient::instance()->createRequest(url);
+    request.setRawHeader("Range", "bytes=" + QByteArray::number(byteOffset) + "-");
+    return m_network->get(request);
+}
+
+void TrackDecoder::pump()
+{
+    if (!m_decoding)
+        return;
+
+    for (;;)
+    {
+        if (m_pendingOffset < m_pending.size())
+        {
+            // Whole frames only, so the mixer never reads half a frame
+            int count = int(qMin<qsizetype>(m_pending.size() - m_pendingOffset, m_ring->space()));
+            count -= count % Channels;
+            m_pendingOffset += m_ring->write(m_pending.constData() + m_pendingOffset, count);
+            if (m_pendingOffset < m_pending.size())
+            {
+                if (!m_pumpTimer->isActive())
+                    m_pumpTimer->start();
+                return;
+            }
+        }
+        if (!m_decoder->bufferAvailable())
+            break;
+        if (!convert(m_decoder->read()))
+            return;
+    }
+    m_pumpTimer->stop();
+
+    if (m_decoderDone)
+    {
+        m_decoding = false;
+        m_decoderDone = false;
+        emit finished(m_generation);
+    }
+}
+
+bool TrackDecoder::convert(const QAudioBuffer &buffer)
+{
+    m_pending.clear();
+    m_pendingOffset = 0;
+    if (!buffer.isValid())
+        return true;
+
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    if (format.sampleRate() != m_format.sampleRate() || channels < 1)
+    {
+        qDebug() << "TrackDecoder: Unsupported decoder output" << format;
+        stop(m_generation);
+        emit errorOccurred(tr("Unsupported audio format"), m_generation);
+        return false;
+    }
+
+    toStereo(buffer, &m_pending);
+
+    // Samples before the seek target, from the start of the song or of the
+    // indexed frame decoding began at, are dropped
+    if (m_skipSamples > 0)
+    {
+        qsizetype skipped = qMin<qsizetype>(m_skipSamples, m_pending.size());
+        m_pendingOffset = skipped;
+        m_skipSamples -= skipped;
+    }
+    return true;
+}
+
+void TrackDecoder::toStereo(const QAudioBuffer &buffer, QList<float> *samples)
+{
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const qsizetype frames = buffer.frameCount();
+    samples->resize(frames * Channels);
+    float *out = samples->data();
+    if (format.sampleFormat() == QAudioFormat::Float && channels == Channels)
+    {
+        std::memcpy(out, buffer.constData<float>(), frames * Channels * sizeof(float));
+        return;
+    }
+
+    // Backends that ignore the requested format; mono is duplicated, extra channels dropped
+    const char *data = buffer.constData<char>();
+    const int bytesPerSample = format.bytesPerSample();
+    for (qsizetype frame = 0; frame < frames; ++frame)
+    {
+        const char *first = data + frame * channels * bytesPerSample;
+        out[frame * Channels] = format.normalizedSampleValue(first);
+        out[frame * Channels + 1] = format.normalizedSampleValue(channels > 1 ? first + bytesPerSample : first);
+    }
+}
+
+void TrackDecoder::onDecoderFinished()
+{
+    m_decoderDone = true;
+    pump();
+}
+
+void TrackDecoder::onDecoderError(QAudioDecoder::Error error)
+{
+    Q_UNUSED(error);
+    QString message = m_decoder->errorString();
+    qDebug() << "TrackDecoder: Decoding failed:" << message;
+    stop(m_generation);
+    emit errorOccurred(message, m_generation);
+}
\ No newline at end of file
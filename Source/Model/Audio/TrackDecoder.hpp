@@ -0,0 +1,79 @@
+#pragma once
+#include <QObject>
+#include <QUrl>
+#include <QAudioFormat>
+#include <QAudioDecoder>
+#include <QList>
+
+class AudioRingBuffer;
+class CachedStream;
+class QIODevice;
+class QNetworkAccessManager;
+class QTimer;
+
+// Decodes one song on a worker thread into the ring buffer of a mixer deck,
+// as interleaved stereo float at the mixer's sample rate. The decoder is only
+// asked for the next buffer once the ring has room, so decoding runs ahead of
+// playback by at most the ring size. Every request carries the deck's
+// generation, which is echoed back so the mixer can drop stale reports.
+class TrackDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    TrackDecoder(AudioRingBuffer *ring, const QAudioFormat &format, QObject *parent = nullptr);
+    ~TrackDecoder();
+
+    // Interleaved stereo float copy of buffer at its own sample rate
+    static void toStereo(const QAudioBuffer &buffer, QList<float> *samples);
+
+public slots:
+    // Resets the ring and decodes url, dropping everything before startMs.
+    // A byteOffset from the song's seek index, where the frame at
+    // byteOffsetMs starts, makes decoding begin there instead of at the
+    // start; a streamed song is then fetched with one ranged request.
+    // A stream, taken over by the decoder, is read instead of url, also by
+    // the song's later seeks as far as the cache has got.
+    void load(const QUrl &url, qint64 startMs, int generation, qint64 byteOffset = 0, qint64 byteOffsetMs = 0,
+              CachedStream *stream = nullptr);
+    void stop(int generation);
+
+signals:
+    void started(int generation);
+    void durationChanged(qint64 durationMs, int generation);
+    // The whole song is in the ring
+    void finished(int generation);
+    void errorOccurred(const QString &error, int generation);
+
+private slots:
+    void pump();
+    void onDecoderFinished();
+    void onDecoderError(QAudioDecoder::Error error);
+
+private:
+    bool convert(const QAudioBuffer &buffer);
+    // byteOffsetMs is where device starts in the song; a null device decodes url
+    void begin(const QUrl &url, QIODevice *device, qint64 startMs, qint64 byteOffsetMs);
+    // The song's cache stream rewound to its start, if there is one
+    QIODevice *wholeStream();
+    // Local files are windowed at byteOffset; remote songs get a ranged request
+    QIODevice *openAt(const QUrl &url, qint64 byteOffset);
+
+    AudioRingBuffer *m_ring;
+    QAudioFormat m_format;
+    QAudioDecoder *m_decoder = nullptr;
+    QTimer *m_pumpTimer;
+    // Source of a decode that starts at a byte offset
+    QIODevice *m_source = nullptr;
+    // Cache reader of the song at m_streamUrl
+    CachedStream *m_stream = nullptr;
+    QUrl m_streamUrl;
+    QNetworkAccessManager *m_network = nullptr;
+    // Songs decoded from an offset report only the remaining duration
+    bool m_reportDuration = true;
+    QList<float> m_pending;
+    qsizetype m_pendingOffset = 0;
+    qint64 m_skipSamples = 0;
+    bool m_decoding = false;
+    bool m_decoderDone = false;
+    int m_generation = 0;
+};
\ No newline at end of file
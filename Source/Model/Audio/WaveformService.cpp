@@ -0,0 +1,303 @@
+#include "WaveformService.hpp"
+#include "AudioFileDecoder.hpp"
+#include "StreamCache.hpp"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define WAVEFORM_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WAVEFORM_NEON
+#endif
+
+namespace
+{
+    const quint32 FileMagic = 0x57415645; // "WAVE"
+    const quint32 FileVersion = 1;
+    // Decoded waveforms kept in memory, at 4 KB each
+    const int MemoryCacheCount = 64;
+    const qint64 InitialBucketFrames = 64;
+    const int MaxWaitingCount = 64;
+
+    void minMax(const float *samples, int count, float *minimum, float *maximum)
+    {
+        float low = *minimum;
+        float high = *maximum;
+        int i = 0;
+#if defined(WAVEFORM_SSE)
+        if (count >= 4)
+        {
+            __m128 low4 = _mm_set1_ps(low);
+            __m128 high4 = _mm_set1_ps(high);
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 v = _mm_loadu_ps(samples + i);
+                low4 = _mm_min_ps(low4, v);
+                high4 = _mm_max_ps(high4, v);
+            }
+            float lows[4];
+            float highs[4];
+            _mm_storeu_ps(lows, low4);
+            _mm_storeu_ps(highs, high4);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                low = std::fmin(low, lows[lane]);
+                high = std::fmax(high, highs[lane]);
+            }
+        }
+#elif defined(WAVEFORM_NEON)
+        if (count >= 4)
+        {
+            float32x4_t low4 = vdupq_n_f32(low);
+            float32x4_t high4 = vdupq_n_f32(high);
+            for (; i + 4 <= count; i += 4)
+            {
+                float32x4_t v = vld1q_f32(samples + i);
+                low4 = vminq_f32(low4, v);
+                high4 = vmaxq_f32(high4, v);
+            }
+            float lows[4];
+            float highs[4];
+            vst1q_f32(lows, low4);
+            vst1q_f32(highs, high4);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                low = std::fmin(low, lows[lane]);
+                high = std::fmax(high, highs[lane]);
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            low = std::fmin(low, samples[i]);
+            high = std::fmax(high, samples[i]);
+        }
+        *minimum = low;
+        *maximum = high;
+    }
+
+    // Buckets of a song whose length is not known up front: once twice the
+    // target count is filled, neighbours are merged and buckets double in
+    // length, so at most 2 * BucketCount buckets are ever held
+    class WaveformBuilder
+    {
+    public:
+        void add(const float *samples, int frames)
+        {
+            while (frames > 0)
+            {
+                int count = int(qMin<qint64>(frames, m_bucketFrames - m_filled));
+                minMax(samples, count * 2, &m_min, &m_max);
+                m_filled += count;
+                samples += count * 2;
+                frames -= count;
+                if (m_filled == m_bucketFrames)
+                    pushBucket();
+            }
+        }
+
+        QByteArray finish()
+        {
+            if (m_filled > 0)
+                pushBucket();
+            const int count = int(m_mins.size());
+            const int buckets = qMin(count, int(WaveformService::BucketCount));
+            QByteArray waveform(buckets * 2, Qt::Uninitialized);
+            for (int bucket = 0; bucket < buckets; ++bucket)
+            {
+                int first = int(qint64(bucket) * count / buckets);
+                int last = int(qint64(bucket + 1) * count / buckets);
+                float low = m_mins[first];
+                float high = m_maxs[first];
+                for (int i = first + 1; i < last; ++i)
+                {
+                    low = qMin(low, m_mins[i]);
+                    high = qMax(high, m_maxs[i]);
+                }
+                waveform[bucket * 2] = char(qRound(qBound(-1.0f, low, 1.0f) * 127.0f));
+                waveform[bucket * 2 + 1] = char(qRound(qBound(-1.0f, high, 1.0f) * 127.0f));
+            }
+            return waveform;
+        }
+
+    private:
+        void pushBucket()
+        {
+            m_mins.append(m_min);
+            m_maxs.append(m_max);
+            m_min = 0.0f;
+            m_max = 0.0f;
+            m_filled = 0;
+            if (m_mins.size() < 2 * WaveformService::BucketCount)
+                return;
+
+            for (int i = 0; i < WaveformService::BucketCount; ++i)
+            {
+                m_mins[i] = qMin(m_mins[2 * i], m_mins[2 * i + 1]);
+                m_maxs[i] = qMax(m_maxs[2 * i], m_maxs[2 * i + 1]);
+            }
+            m_mins.resize(WaveformService::BucketCount);
+            m_maxs.resize(WaveformService::BucketCount);
+            m_bucketFrames *= 2;
+        }
+
+        qint64 m_bucketFrames = InitialBucketFrames;
+        qint64 m_filled = 0;
+        float m_min = 0.0f;
+        float m_max = 0.0f;
+        QList<float> m_mins;
+        QList<float> m_maxs;
+    };
+}
+
+WaveformService *WaveformService::m_instance = nullptr;
+
+WaveformService::WaveformService(QObject *parent)
+    : QObject(parent),
+      m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/waveforms"),
+      m_waveforms(MemoryCacheCount)
+{
+    QDir().mkpath(m_directory);
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &WaveformService::onGenerated);
+    connect(StreamCache::instance(), &StreamCache::songCached, this, &WaveformService::onSongCached);
+    if (QCoreApplication::instance())
+    {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]()
+                {
+            m_cancelled = true;
+            m_pool.waitForDone(); });
+    }
+}
+
+WaveformService *WaveformService::instance()
+{
+    if (!m_instance)
+    {
+        m_instance = new WaveformService();
+    }
+    return m_instance;
+}
+
+QByteArray WaveformService::waveform(int songId)
+{
+    if (QByteArray *waveform = m_waveforms.object(songId))
+        return *waveform;
+
+    QByteArray stored;
+    if (load(songId, &stored))
+    {
+        m_waveforms.insert(songId, new QByteArray(stored));
+        return stored;
+    }
+
+    if (songId == m_current || m_queue.contains(songId))
+        return QByteArray();
+    m_waiting.removeOne(songId);
+    if (StreamCache::instance()->isComplete(songId))
+    {
+        m_queue.append(songId);
+        startNext();
+    }
+    else
+    {
+        // Asking again puts a dropped song back
+        if (m_waiting.size() >= MaxWaitingCount)
+            m_waiting.removeFirst();
+        m_waiting.append(songId);
+    }
+    return QByteArray();
+}
+
+void WaveformService::onSongCached(int songId)
+{
+    if (!m_waiting.removeOne(songId))
+        return;
+    m_queue.append(songId);
+    startNext();
+}
+
+void WaveformService::startNext()
+{
+    while (m_current == -1 && !m_queue.isEmpty())
+    {
+        int songId = m_queue.takeFirst();
+        QString filePath = StreamCache::instance()->localFile(songId);
+        if (filePath.isEmpty())
+            continue;
+        m_current = songId;
+        m_watcher.setFuture(QtConcurrent::run(&m_pool, &WaveformService::generate, filePath, &m_cancelled));
+    }
+}
+
+void WaveformService::onGenerated()
+{
+    int songId = m_current;
+    m_current = -1;
+    Result result = m_watcher.result();
+    // A file evicted while it was read is no reason to give up on the song
+    if (result.complete && (!result.waveform.isEmpty() || StreamCache::instance()->isComplete(songId)))
+    {
+        save(songId, result.waveform);
+        m_waveforms.insert(songId, new QByteArray(result.waveform));
+        if (result.waveform.isEmpty())
+            qDebug() << "WaveformService: Song" << songId << "could not be decoded";
+        else
+            emit waveformReady(songId);
+    }
+    startNext();
+}
+
+WaveformService::Result WaveformService::generate(const QString &filePath, const std::atomic<bool> *cancelled)
+{
+    WaveformBuilder builder;
+    auto consume = [&builder](const float *samples, int frames, int)
+    {
+        builder.add(samples, frames);
+    };
+    AudioFileDecoder::Result decoded = AudioFileDecoder::decode(filePath, consume, cancelled);
+    if (decoded == AudioFileDecoder::Cancelled)
+        return {QByteArray(), false};
+    if (decoded == AudioFileDecoder::Failed)
+        return {QByteArray(), true};
+    return {builder.finish(), true};
+}
+
+QString WaveformService::filePath(int songId) const
+{
+    return m_directory + "/" + QString::number(songId) + ".wave";
+}
+
+bool WaveformService::load(int songId, QByteArray *waveform) const
+{
+    QFile file(filePath(songId));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version >> *waveform;
+    return in.status() == QDataStream::Ok && magic == FileMagic && version == FileVersion;
+}
+
+void WaveformService::save(int songId, const QByteArray &waveform) const
+{
+    QSaveFile file(filePath(songId));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << FileMagic << FileVersion << waveform;
+    file.commit();
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <atomic>
+
+// Min/max overview of each song for drawing its waveform. Generated from the
+// song's cached file on a background thread in one streaming pass, with
+// memory bounded by the bucket count whatever the song length, and stored
+// on disk as a few KB per song. Songs that cannot be decoded are stored as
+// an empty waveform and not tried again.
+class WaveformService : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int BucketCount = 2048;
+
+    static WaveformService *instance();
+
+    // Min and max of every bucket as signed 8-bit pairs. Empty until ready;
+    // waveformReady() follows once it is loaded or generated. Stays empty
+    // for a song that failed to decode.
+    QByteArray waveform(int songId);
+
+signals:
+    void waveformReady(int songId);
+
+private slots:
+    void onSongCached(int songId);
+    void onGenerated();
+
+private:
+    struct Result
+    {
+        // Empty if the song could not be decoded
+        QByteArray waveform;
+        bool complete;
+    };
+
+    WaveformService(QObject *parent = nullptr);
+    QString filePath(int songId) const;
+    // False if nothing is stored for the song
+    bool load(int songId, QByteArray *waveform) const;
+    void save(int songId, const QByteArray &waveform) const;
+    void startNext();
+    static Result generate(const QString &filePath, const std::atomic<bool> *cancelled);
+
+    static WaveformService *m_instance;
+    QString m_directory;
+    QCache<int, QByteArray> m_waveforms;
+    QList<int> m_queue;
+    // Requested before the stream cache had the whole song, oldest first;
+    // bounded, since some songs are never cached completely
+    QList<int> m_waiting;
+    int m_current = -1;
+    QThreadPool m_pool;
+    QFutureWatcher<Result> m_watcher;
+    std::atomic<bool> m_cancelled{false};
+};
\ No newline at end of file
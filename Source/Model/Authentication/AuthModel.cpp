@@ -1,6 +1,7 @@
 #include "AuthModel.hpp"
 #include "AppConfig.hpp"
 #include "AppState.hpp"
+#include "HttpClient.hpp"
 #include <QUrl>
 #include <QNetworkRequest>
 #include <QJsonObject>
@@ -10,7 +11,6 @@
 
 AuthModel::AuthModel(QObject *parent)
     : QObject(parent),
-      m_networkManager(new QNetworkAccessManager(this)),
       m_settings(new QSettings("MediaPlayer", "Auth", this))
 {
 }
@@ -33,7 +33,7 @@ void AuthModel::loginUser(const QString &email, const QString &password)
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager->post(request, data);
+    QNetworkReply *reply = HttpClient::instance()->post(request, data);
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
         handleNetworkReply(reply, true);
@@ -78,7 +78,7 @@ void AuthModel::registerUser(const QString &email, const QString &password, cons
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager->post(request, data);
+    QNetworkReply *reply = HttpClient::instance()->post(request, data);
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
         handleNetworkReply(reply, false);
@@ -96,7 +96,6 @@ void AuthModel::updateProfile(int userId, const QString &name, const QString &do
     QUrl url(AppConfig::instance().getAuthUpdateEndpoint(userId));
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Authorization", "Bearer " + getToken().toUtf8());
 
     QJsonObject json;
     bool hasData = false;
@@ -148,7 +147,7 @@ void AuthModel::updateProfile(int userId, const QString &name, const QString &do
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager->put(request, data);
+    QNetworkReply *reply = HttpClient::instance()->put(request, data);
     connect(reply, &QNetworkReply::finished, this, [=]()
             {
         handleNetworkReply(reply, false, true);
@@ -1,6 +1,5 @@
 #pragma once
 #include <QObject>
-#include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QSettings>
 
@@ -23,7 +22,6 @@ signals:
     void profileUpdateResult(bool success, const QString &message);
 
 private:
-    QNetworkAccessManager *m_networkManager;
     QSettings *m_settings;
     void handleNetworkReply(QNetworkReply *reply, bool isLogin, bool isUpdate = false);
     void saveToken(const QString &token);
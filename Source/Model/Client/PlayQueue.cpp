@@ -0,0 +1,302 @@
+#include "PlayQueue.hpp"
+#include "SongCatalog.hpp"
+#include <QDebug>
+#include <QSet>
+
+PlayQueue::PlayQueue(QObject *parent) : KeyedListModel(parent) {}
+
+PlayQueue::~PlayQueue()
+{
+    SongCatalog::instance().release(m_songIds);
+}
+
+int PlayQueue::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_songIds.count();
+}
+
+QVariant PlayQueue::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_songIds.count())
+        return QVariant();
+
+    const SongCatalog &catalog = SongCatalog::instance();
+    int songId = m_songIds.at(index.row());
+    switch (role)
+    {
+    case IdRole:
+        return songId;
+    case TitleRole:
+        return catalog.title(songId);
+    case ArtistsRole:
+        return catalog.artists(songId);
+    case FilePathRole:
+        return catalog.filePath(songId);
+    case GenresRole:
+        return catalog.genres(songId);
+    case IsCurrentRole:
+        return index.row() == m_currentIndex;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> PlayQueue::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[IdRole] = "id";
+    roles[TitleRole] = "title";
+    roles[ArtistsRole] = "artists";
+    roles[FilePathRole] = "file_path";
+    roles[GenresRole] = "genres";
+    roles[IsCurrentRole] = "isCurrent";
+    return roles;
+}
+
+void PlayQueue::setSongs(const QList<int> &songIds)
+{
+    m_sourceIds = songIds;
+    if (songIds == m_songIds)
+        return;
+    int previousCount = m_songIds.count();
+    replaceSongs(songIds);
+    m_nextIndex = -1;
+
+    // The diff keeps rows in place, but the current entry may have moved or left
+    int index = m_currentSongId == -1 ? -1 : m_songIds.indexOf(m_currentSongId);
+    if (index == -1)
+        m_currentSongId = -1;
+    updateCurrent(index);
+    if (previousCount != m_songIds.count())
+        emit countChanged();
+    emit queueChanged();
+}
+
+void PlayQueue::mergeSongs(const QList<int> &songIds)
+{
+    if (songIds == m_sourceIds)
+        return;
+    const QSet<int> previousSource(m_sourceIds.cbegin(), m_sourceIds.cend());
+    const QSet<int> source(songIds.cbegin(), songIds.cend());
+    m_sourceIds = songIds;
+
+    QList<int> kept;
+    kept.reserve(m_songIds.count());
+    int currentKept = -1;
+    int nextKept = -1;
+    for (int i = 0; i < m_songIds.count(); ++i)
+    {
+        int songId = m_songIds.at(i);
+        if (m_nextIndex >= 0 && nextKept == -1 && i >= m_nextIndex)
+            nextKept = kept.count();
+        if (i == m_currentIndex)
+            currentKept = kept.count();
+        else if (previousSource.contains(songId) && !source.contains(songId))
+            continue;
+        kept.append(songId);
+    }
+
+    // Each run of new songs follows the closest song before it that is
+    // queued; songs the user removed stay out
+    const QSet<int> queued(kept.cbegin(), kept.cend());
+    QList<int> front;
+    QHash<int, QList<int>> after;
+    int anchor = -1;
+    for (int songId : songIds)
+    {
+        if (queued.contains(songId))
+            anchor = songId;
+        else if (!previousSource.contains(songId))
+            (anchor == -1 ? front : after[anchor]).append(songId);
+    }
+
+    QList<int> merged = front;
+    merged.reserve(m_songIds.count() + songIds.count());
+    int current = -1;
+    int next = -1;
+    for (int i = 0; i < kept.count(); ++i)
+    {
+        if (i == currentKept)
+            current = merged.count();
+        if (i == nextKept)
+            next = merged.count();
+        merged.append(kept.at(i));
+        auto block = after.find(kept.at(i));
+        if (block != after.end())
+        {
+            merged.append(*block);
+            after.erase(block);
+        }
+    }
+    // Nothing queued was left after the removed current entry
+    if (m_nextIndex >= 0 && nextKept == -1)
+        next = merged.count();
+    if (merged == m_songIds)
+        return;
+
+    int previousCount = m_songIds.count();
+    replaceSongs(merged);
+    updateCurrent(current);
+    m_nextIndex = current == -1 ? next : -1;
+    if (previousCount != m_songIds.count())
+        emit countChanged();
+    emit queueChanged();
+}
+
+void PlayQueue::setCurrentIndex(int index)
+{
+    if (index < -1 || index >= m_songIds.count())
+        return;
+    m_nextIndex = -1;
+    m_currentSongId = songIdAt(index);
+    updateCurrent(index);
+}
+
+bool PlayQueue::setCurrentSongId(int songId)
+{
+    if (songIdAt(m_currentIndex) == songId)
+        return true;
+    // Next and previous are by far the most common targets
+    for (int candidate : {m_currentIndex + 1, m_currentIndex - 1})
+    {
+        if (songIdAt(candidate) == songId)
+        {
+            setCurrentIndex(candidate);
+            return true;
+        }
+    }
+    int index = m_songIds.indexOf(songId);
+    if (index == -1)
+        return false;
+    setCurrentIndex(index);
+    return true;
+}
+
+int PlayQueue::nextIndex(bool wrap) const
+{
+    if (m_songIds.isEmpty())
+        return -1;
+    if (followingRow() < m_songIds.count())
+        return followingRow();
+    return wrap ? 0 : -1;
+}
+
+int PlayQueue::previousIndex(bool wrap) const
+{
+    if (m_songIds.isEmpty())
+        return -1;
+    int row = m_currentIndex != -1 ? m_currentIndex : followingRow();
+    if (row > 0)
+        return row - 1;
+    return wrap ? m_songIds.count() - 1 : -1;
+}
+
+void PlayQueue::insertNext(int songId)
+{
+    insertAt(followingRow(), songId);
+}
+
+void PlayQueue::append(int songId)
+{
+    insertAt(m_songIds.count(), songId);
+}
+
+void PlayQueue::remove(int index)
+{
+    if (index < 0 || index >= m_songIds.count())
+        return;
+
+    int songId = m_songIds.at(index);
+    beginRemoveRows(QModelIndex(), index, index);
+    m_songIds.removeAt(index);
+    endRemoveRows();
+    SongCatalog::instance().release({songId});
+
+    if (index < m_currentIndex)
+    {
+        updateCurrent(m_currentIndex - 1);
+    }
+    else if (index == m_currentIndex)
+    {
+        // The playing song keeps playing but is no longer in the queue; next
+        // continues with the entry that took its place
+        m_currentSongId = -1;
+        updateCurrent(-1);
+        m_nextIndex = index;
+    }
+    else if (index < m_nextIndex)
+    {
+        --m_nextIndex;
+    }
+    emit countChanged();
+    emit queueChanged();
+}
+
+void PlayQueue::move(int from, int to)
+{
+    if (from < 0 || from >= m_songIds.count() || to < 0 || to >= m_songIds.count() || from == to)
+        return;
+
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+    m_songIds.move(from, to);
+    endMoveRows();
+
+    int current = m_currentIndex;
+    if (current == from)
+        current = to;
+    else if (from < current && to >= current)
+        --current;
+    else if (from > current && to <= current)
+        ++current;
+    updateCurrent(current);
+    // The next position sits between two rows rather than on one
+    if (m_nextIndex >= 0 && from < m_nextIndex && to >= m_nextIndex)
+        --m_nextIndex;
+    else if (m_nextIndex >= 0 && from >= m_nextIndex && to < m_nextIndex)
+        ++m_nextIndex;
+    emit queueChanged();
+}
+
+void PlayQueue::replaceSongs(const QList<int> &songIds)
+{
+    SongCatalog &catalog = SongCatalog::instance();
+    catalog.retain(songIds);
+    QList<int> previous = m_songIds;
+    applyRows(m_songIds, songIds, [](int id) { return id; },
+              [](int, int) { return false; });
+    catalog.release(previous);
+}
+
+void PlayQueue::insertAt(int index, int songId)
+{
+    if (!SongCatalog::instance().contains(songId))
+    {
+        qDebug() << "PlayQueue: Song" << songId << "is not loaded, cannot queue it";
+        return;
+    }
+    index = qBound(0, index, m_songIds.count());
+    SongCatalog::instance().retain({songId});
+    beginInsertRows(QModelIndex(), index, index);
+    m_songIds.insert(index, songId);
+    endInsertRows();
+    if (index <= m_currentIndex)
+        updateCurrent(m_currentIndex + 1);
+    else if (index < m_nextIndex)
+        ++m_nextIndex;
+    emit countChanged();
+    emit queueChanged();
+}
+
+void PlayQueue::updateCurrent(int index)
+{
+    if (index == m_currentIndex)
+        return;
+    int previous = m_currentIndex;
+    m_currentIndex = index;
+    if (previous >= 0 && previous < m_songIds.count())
+        emit dataChanged(this->index(previous), this->index(previous), {IsCurrentRole});
+    if (index >= 0)
+        emit dataChanged(this->index(index), this->index(index), {IsCurrentRole});
+    emit currentIndexChanged();
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include "KeyedListModel.hpp"
+
+// Ordered list of song ids to play, with the current position tracked by
+// both index and song id. Stepping forward or back is O(1); edits keep the
+// current position on the same entry. The list the queue was built from is
+// kept apart from the edits, so a later version of it can be merged in
+// without undoing them. Fields are resolved through the SongCatalog, whose
+// entries stay alive while they are in the queue.
+class PlayQueue : public KeyedListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int currentIndex READ currentIndex WRITE setCurrentIndex NOTIFY currentIndexChanged)
+    Q_PROPERTY(int currentSongId READ currentSongId NOTIFY currentIndexChanged)
+
+public:
+    explicit PlayQueue(QObject *parent = nullptr);
+    ~PlayQueue();
+
+    enum QueueRoles
+    {
+        IdRole = Qt::UserRole + 1,
+        TitleRole,
+        ArtistsRole,
+        FilePathRole,
+        GenresRole,
+        IsCurrentRole
+    };
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const { return m_songIds.count(); }
+    int currentIndex() const { return m_currentIndex; }
+    int currentSongId() const { return m_currentSongId; }
+    const QList<int> &songIds() const { return m_songIds; }
+    int songIdAt(int index) const { return m_songIds.value(index, -1); }
+
+    // Replaces the queue and its source list, keeping the current song if it is still queued
+    void setSongs(const QList<int> &songIds);
+    // Applies what changed between the source list and songIds to the edited
+    // queue: songs that left the source leave the queue, except the playing
+    // entry, and new songs go in after the song before them in songIds
+    void mergeSongs(const QList<int> &songIds);
+    void setCurrentIndex(int index);
+    // Moves the current position to songId, searching from the current entry outwards
+    bool setCurrentSongId(int songId);
+    int nextIndex(bool wrap) const;
+    int previousIndex(bool wrap) const;
+
+    Q_INVOKABLE void insertNext(int songId);
+    Q_INVOKABLE void append(int songId);
+    Q_INVOKABLE void remove(int index);
+    Q_INVOKABLE void move(int from, int to);
+
+signals:
+    void countChanged();
+    void currentIndexChanged();
+    void queueChanged();
+
+private:
+    // Row of the entry that plays after the current one
+    int followingRow() const { return m_currentIndex != -1 ? m_currentIndex + 1 : qMax(m_nextIndex, 0); }
+    void replaceSongs(const QList<int> &songIds);
+    void insertAt(int index, int songId);
+    void updateCurrent(int index);
+
+    QList<int> m_songIds;
+    // As last given to setSongs() or mergeSongs()
+    QList<int> m_sourceIds;
+    int m_currentIndex = -1;
+    int m_currentSongId = -1;
+    // With no current entry, the row next continues from, e.g. after the
+    // playing song was removed; -1 otherwise
+    int m_nextIndex = -1;
+};
\ No newline at end of file
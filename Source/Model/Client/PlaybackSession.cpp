@@ -0,0 +1,123 @@
+#include "PlaybackSession.hpp"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+
+namespace
+{
+    const quint32 StateMagic = 0x53455353; // "SESS"
+    const quint32 QueueMagic = 0x53455351; // "SESQ"
+    const quint32 SnapshotVersion = 1;
+    const int SaveIntervalMs = 5000;
+
+    bool openStream(QFile *file, QDataStream *in, quint32 magic)
+    {
+        if (!file->open(QIODevice::ReadOnly))
+            return false;
+        in->setDevice(file);
+        quint32 fileMagic = 0;
+        quint32 version = 0;
+        *in >> fileMagic >> version;
+        return fileMagic == magic && version == SnapshotVersion;
+    }
+}
+
+PlaybackSession::PlaybackSession(QObject *parent)
+    : QObject(parent),
+      m_statePath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.dat"),
+      m_queuePath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session-queue.dat"),
+      m_saveTimer(new QTimer(this))
+{
+    QDir().mkpath(QFileInfo(m_statePath).absolutePath());
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SaveIntervalMs);
+    connect(m_saveTimer, &QTimer::timeout, this, &PlaybackSession::save);
+    if (QCoreApplication::instance())
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &PlaybackSession::flush);
+}
+
+bool PlaybackSession::load(PlaybackSnapshot *snapshot) const
+{
+    QFile stateFile(m_statePath);
+    QDataStream state;
+    if (!openStream(&stateFile, &state, StateMagic))
+        return false;
+    qint32 userId = -1;
+    qint32 playlistId = -1;
+    qint32 currentSongId = -1;
+    qint32 repeatMode = 0;
+    state >> userId >> playlistId >> snapshot->playlistName >> currentSongId >> snapshot->positionMs >> snapshot->shuffle >> repeatMode;
+    if (state.status() != QDataStream::Ok)
+        return false;
+
+    QFile queueFile(m_queuePath);
+    QDataStream queue;
+    if (!openStream(&queueFile, &queue, QueueMagic))
+        return false;
+    queue >> snapshot->songs;
+    if (queue.status() != QDataStream::Ok)
+        return false;
+
+    snapshot->userId = userId;
+    snapshot->playlistId = playlistId;
+    snapshot->currentSongId = currentSongId;
+    snapshot->repeatMode = repeatMode;
+    return true;
+}
+
+void PlaybackSession::scheduleSave(bool queueChanged)
+{
+    m_queueDirty = m_queueDirty || queueChanged;
+    // Not restarted, so a steady stream of changes still writes every interval
+    if (!m_saveTimer->isActive())
+        m_saveTimer->start();
+}
+
+void PlaybackSession::flush()
+{
+    if (!m_saveTimer->isActive())
+        return;
+    m_saveTimer->stop();
+    save();
+}
+
+void PlaybackSession::save()
+{
+    if (!m_provider)
+        return;
+    const PlaybackSnapshot snapshot = m_provider(m_queueDirty);
+
+    // Queue first: a crash in between leaves a state whose current song may
+    // be missing from the queue, which restoring already has to handle
+    if (m_queueDirty)
+    {
+        QSaveFile queueFile(m_queuePath);
+        if (!queueFile.open(QIODevice::WriteOnly))
+        {
+            qDebug() << "PlaybackSession: Cannot write queue:" << queueFile.errorString();
+            return;
+        }
+        QDataStream queue(&queueFile);
+        queue << QueueMagic << SnapshotVersion << snapshot.songs;
+        if (!queueFile.commit())
+            return;
+        m_queueDirty = false;
+    }
+
+    QSaveFile stateFile(m_statePath);
+    if (!stateFile.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "PlaybackSession: Cannot write state:" << stateFile.errorString();
+        return;
+    }
+    QDataStream state(&stateFile);
+    state << StateMagic << SnapshotVersion << qint32(snapshot.userId) << qint32(snapshot.playlistId) << snapshot.playlistName
+          << qint32(snapshot.currentSongId) << snapshot.positionMs << snapshot.shuffle << qint32(snapshot.repeatMode);
+    stateFile.commit();
+}
\ No newline at end of file
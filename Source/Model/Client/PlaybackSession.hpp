@@ -0,0 +1,54 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QVariantMap>
+#include <functional>
+
+class QTimer;
+
+// What was playing, in the order the queue had it
+struct PlaybackSnapshot
+{
+    int userId = -1;
+    int playlistId = -1;
+    QString playlistName;
+    // Queue songs in the shape SongCatalog::toVariantMap() gives them, so
+    // the queue comes back without waiting for the server
+    QList<QVariantMap> songs;
+    int currentSongId = -1;
+    qint64 positionMs = 0;
+    bool shuffle = false;
+    int repeatMode = 0;
+};
+
+// Journal of the playback session in two small binary files, so a restart
+// resumes where it left off: the queue, rewritten only when it changes,
+// and the rest, a few dozen bytes. Writes go through QSaveFile, so a crash
+// leaves either the old or the new file, and are debounced to at most one
+// per interval however often the session changes.
+class PlaybackSession : public QObject
+{
+    Q_OBJECT
+public:
+    // songs only needs filling when withSongs is set
+    using Provider = std::function<PlaybackSnapshot(bool withSongs)>;
+
+    explicit PlaybackSession(QObject *parent = nullptr);
+
+    // False if there is no readable snapshot
+    bool load(PlaybackSnapshot *snapshot) const;
+    // Called when a write is due, so a snapshot is only built that often
+    void setProvider(const Provider &provider) { m_provider = provider; }
+    void scheduleSave(bool queueChanged = false);
+    // Writes straight away if a write is pending
+    void flush();
+
+private:
+    void save();
+
+    QString m_statePath;
+    QString m_queuePath;
+    QTimer *m_saveTimer;
+    Provider m_provider;
+    bool m_queueDirty = false;
+};
\ No newline at end of file
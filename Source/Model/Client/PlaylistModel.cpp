@@ -1,37 +1,48 @@
 #include "PlaylistModel.hpp"
 #include "AppConfig.hpp"
+#include "HttpClient.hpp"
+#include "SongCatalog.hpp"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QUrlQuery>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QElapsedTimer>
 #include <QDebug>
 
-PageSongModel::PageSongModel(QObject *parent) : QAbstractListModel(parent) {}
+PageSongModel::PageSongModel(QObject *parent) : KeyedListModel(parent) {}
+
+PageSongModel::~PageSongModel()
+{
+    SongCatalog::instance().release(m_songIds);
+}
 
 int PageSongModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return m_songs.count();
+    return m_source ? m_length : m_songIds.count();
 }
 
 QVariant PageSongModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() >= m_songs.count())
+    if (index.row() < 0 || index.row() >= rowCount())
         return QVariant();
 
-    const SongData &song = m_songs[index.row()];
+    const SongCatalog &catalog = SongCatalog::instance();
+    int songId = m_source ? m_source->at(m_offset + index.row()) : m_songIds.at(index.row());
     switch (role)
     {
     case IdRole:
-        return song.id;
+        return songId;
     case TitleRole:
-        return song.title;
+        return catalog.title(songId);
     case ArtistsRole:
-        return song.artists;
+        return catalog.artists(songId);
     case FilePathRole:
-        return song.filePath;
+        return catalog.filePath(songId);
     case GenresRole:
-        return song.genres;
+        return catalog.genres(songId);
     default:
         return QVariant();
     }
@@ -48,27 +59,117 @@ QHash<int, QByteArray> PageSongModel::roleNames() const
     return roles;
 }
 
-void PageSongModel::setSongs(const QList<SongData> &songs)
+void PageSongModel::setSongs(const QList<int> &songIds, const QSet<int> &changedIds)
+{
+    SongCatalog &catalog = SongCatalog::instance();
+    catalog.retain(songIds);
+    QList<int> previous = m_songIds;
+    applyRows(m_songIds, songIds, [](int id) { return id; },
+              [&changedIds](int id, int) { return changedIds.contains(id); });
+    catalog.release(previous);
+}
+
+void PageSongModel::clear()
 {
     beginResetModel();
-    m_songs = songs;
+    SongCatalog::instance().release(m_songIds);
+    m_songIds.clear();
+    m_offset = 0;
+    m_length = 0;
     endResetModel();
 }
 
-void PageSongModel::clear()
+void PageSongModel::setSource(const QList<int> *songIds)
 {
     beginResetModel();
-    m_songs.clear();
+    m_source = songIds;
+    m_offset = 0;
+    m_length = 0;
     endResetModel();
 }
 
+void PageSongModel::setWindow(int offset, int length)
+{
+    if (offset == m_offset && length == m_length)
+        return;
+    int previousOffset = m_offset;
+    int kept = moveWindow(m_source, offset, length);
+    if (offset != previousOffset && kept > 0)
+        emit dataChanged(index(0), index(kept - 1));
+}
+
+void PageSongModel::sourceChanged(const QList<int> &previous, int offset, int length, const QSet<int> &changedIds)
+{
+    // The owner has already changed the list; until the window has changed
+    // too, rows are served from the copy it had before
+    const QList<int> *source = m_source;
+    m_source = &previous;
+    int previousOffset = m_offset;
+    int kept = moveWindow(source, offset, length);
+    auto rowChanged = [&](int row)
+    {
+        int songId = m_source->at(m_offset + row);
+        return previous.value(previousOffset + row, -1) != songId || changedIds.contains(songId);
+    };
+
+    int row = 0;
+    while (row < kept)
+    {
+        if (!rowChanged(row))
+        {
+            ++row;
+            continue;
+        }
+        int first = row;
+        while (row < kept && rowChanged(row))
+            ++row;
+        emit dataChanged(index(first), index(row - 1));
+    }
+}
+
+int PageSongModel::moveWindow(const QList<int> *source, int offset, int length)
+{
+    // Rows past the shorter of the two windows are added or dropped at the tail;
+    // the rows both windows share are returned for the caller to refresh. The
+    // new source and bounds only apply between begin and end, so views see the
+    // old rows before the change and the new ones after it.
+    int kept = qMin(m_length, length);
+    if (length > m_length)
+    {
+        beginInsertRows(QModelIndex(), m_length, length - 1);
+        m_source = source;
+        m_offset = offset;
+        m_length = length;
+        endInsertRows();
+    }
+    else if (length < m_length)
+    {
+        beginRemoveRows(QModelIndex(), length, m_length - 1);
+        m_source = source;
+        m_offset = offset;
+        m_length = length;
+        endRemoveRows();
+    }
+    else
+    {
+        m_source = source;
+        m_offset = offset;
+    }
+    return kept;
+}
+
 PlaylistModel::PlaylistModel(QObject *parent)
-    : QAbstractListModel(parent),
-      m_networkManager(),
+    : KeyedListModel(parent),
       m_settings(new QSettings("MediaPlayer", "Auth", this)),
       m_pageSongModel(new PageSongModel(this)),
       m_searchSongModel(new PageSongModel(this))
 {
+    m_pageSongModel->setSource(&m_currentSongs);
+}
+
+PlaylistModel::~PlaylistModel()
+{
+    SongCatalog::instance().release(m_currentSongs);
 }
 
 int PlaylistModel::rowCount(const QModelIndex &parent) const
@@ -152,12 +253,16 @@ void PlaylistModel::setItemsPerPage(int items)
 void PlaylistModel::updatePageSongs()
 {
     int startIndex = m_currentPage * m_itemsPerPage;
-    int endIndex = qMin(startIndex + m_itemsPerPage, m_currentSongs.count());
-    QList<SongData> pageSongs;
-    for (int i = startIndex; i < endIndex; ++i)
-        pageSongs.append(m_currentSongs[i]);
-    m_pageSongModel->setSongs(pageSongs);
-    qDebug() << "PlaylistModel: Updated page songs, count:" << pageSongs.count() << ", startIndex:" << startIndex << ", endIndex:" << endIndex;
+    int length = qBound(0, m_currentSongs.count() - startIndex, m_itemsPerPage);
+    m_pageSongModel->setWindow(startIndex, length);
+    qDebug() << "PlaylistModel: Updated page songs, count:" << length << ", startIndex:" << startIndex;
+}
+
+void PlaylistModel::refreshPageSongs(const QList<int> &previous, const QSet<int> &changedIds)
+{
+    int startIndex = m_currentPage * m_itemsPerPage;
+    int length = qBound(0, m_currentSongs.count() - startIndex, m_itemsPerPage);
+    m_pageSongModel->sourceChanged(previous, startIndex, length, changedIds);
 }
 
 void PlaylistModel::loadUserPlaylists()
@@ -172,12 +277,16 @@ void PlaylistModel::loadUserPlaylists()
 
     QUrl url(AppConfig::instance().getPlaylistsEndpoint());
     QNetworkRequest request(url);
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
-    QNetworkReply *reply = m_networkManager.get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_playlistRequests.start(reply);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
-            { handleNetworkReply(reply); });
+            {
+        if (!m_playlistRequests.isCurrent(reply))
+        {
+            reply->deleteLater();
+            return;
+        }
+        handleNetworkReply(reply); });
 }
 
 void PlaylistModel::createPlaylist(const QString &name)
@@ -198,16 +307,13 @@ void PlaylistModel::createPlaylist(const QString &name)
     QUrl url(AppConfig::instance().getPlaylistsEndpoint());
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
     QJsonObject json;
     json["name"] = name;
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager.post(request, data);
+    QNetworkReply *reply = HttpClient::instance()->post(request, data);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
             { handleNetworkReply(reply); });
 }
@@ -230,16 +336,13 @@ void PlaylistModel::updatePlaylist(int playlistId, const QString &name)
     QUrl url(AppConfig::instance().getPlaylistEndpoint(playlistId));
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
     QJsonObject json;
     json["name"] = name;
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager.put(request, data);
+    QNetworkReply *reply = HttpClient::instance()->put(request, data);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
             { handleNetworkReply(reply); });
 }
@@ -261,11 +364,8 @@ void PlaylistModel::deletePlaylist(int playlistId)
 
     QUrl url(AppConfig::instance().getPlaylistEndpoint(playlistId));
     QNetworkRequest request(url);
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
-    QNetworkReply *reply = m_networkManager.deleteResource(request);
+    QNetworkReply *reply = HttpClient::instance()->deleteResource(request);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
             { handleNetworkReply(reply); });
 }
@@ -288,9 +388,6 @@ void PlaylistModel::addSongToPlaylist(int playlistId, int songId)
     QUrl url(AppConfig::instance().getPlaylistsSongsEndpoint());
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
     QJsonObject json;
     json["playlistId"] = playlistId;
@@ -298,7 +395,7 @@ void PlaylistModel::addSongToPlaylist(int playlistId, int songId)
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager.post(request, data);
+    QNetworkReply *reply = HttpClient::instance()->post(request, data);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
             { handleNetworkReply(reply); });
 }
@@ -321,9 +418,6 @@ void PlaylistModel::removeSongFromPlaylist(int playlistId, int songId)
     QUrl url(AppConfig::instance().getPlaylistsRemoveSongEndpoint());
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
     QJsonObject json;
     json["playlistId"] = playlistId;
@@ -331,7 +425,7 @@ void PlaylistModel::removeSongFromPlaylist(int playlistId, int songId)
     QJsonDocument doc(json);
     QByteArray data = doc.toJson();
 
-    QNetworkReply *reply = m_networkManager.sendCustomRequest(request, "DELETE", data);
+    QNetworkReply *reply = HttpClient::instance()->sendCustomRequest(request, "DELETE", data);
     connect(reply, &QNetworkReply::finished, this, [this, reply, playlistId, songId]()
             { handleNetworkReply(reply, playlistId, songId); });
 }
@@ -353,13 +447,17 @@ void PlaylistModel::loadSongsInPlaylist(int playlistId)
 
     QUrl url(AppConfig::instance().getPlaylistSongsEndpoint(playlistId));
     QNetworkRequest request(url);
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
-    QNetworkReply *reply = m_networkManager.get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_playlistSongRequests.start(reply);
     connect(reply, &QNetworkReply::finished, this, [this, reply, playlistId]()
-            { handleNetworkReply(reply, playlistId); });
+            {
+        if (!m_playlistSongRequests.isCurrent(reply))
+        {
+            reply->deleteLater();
+            return;
+        }
+        handleNetworkReply(reply, playlistId); });
 }
 
 void PlaylistModel::search(const QString &query, int limit, int offset)
@@ -390,13 +488,17 @@ void PlaylistModel::search(const QString &query, int limit, int offset)
     url.setQuery(queryParams);
 
     QNetworkRequest request(url);
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
-    QNetworkReply *reply = m_networkManager.get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_playlistSearchRequests.start(reply);
     connect(reply, &QNetworkReply::finished, this, [this, reply]()
-            { handleNetworkReply(reply); });
+            {
+        if (!m_playlistSearchRequests.isCurrent(reply))
+        {
+            reply->deleteLater();
+            return;
+        }
+        handleNetworkReply(reply); });
 }
 
 void PlaylistModel::searchSongsInPlaylist(int playlistId, const QString &query, int limit, int offset)
@@ -432,13 +534,163 @@ void PlaylistModel::searchSongsInPlaylist(int playlistId, const QString &query,
     url.setQuery(queryParams);
 
     QNetworkRequest request(url);
-    QString token = m_settings->value("jwt_token").toString();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
 
-    QNetworkReply *reply = m_networkManager.get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_songSearchRequests.start(reply);
     connect(reply, &QNetworkReply::finished, this, [this, reply, playlistId]()
-            { handleNetworkReply(reply, playlistId); });
+            {
+        if (!m_songSearchRequests.isCurrent(reply))
+        {
+            reply->deleteLater();
+            return;
+        }
+        handleNetworkReply(reply, playlistId); });
+}
+
+QList<PlaylistData> PlaylistModel::parsePlaylists(const QByteArray &data, bool *ok)
+{
+    QList<PlaylistData> playlists;
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (ok)
+        *ok = doc.isArray();
+    if (!doc.isArray())
+        return playlists;
+
+    QJsonArray jsonArray = doc.array();
+    playlists.reserve(jsonArray.size());
+    for (const QJsonValue &value : jsonArray)
+    {
+        QJsonObject obj = value.toObject();
+        PlaylistData playlist;
+        playlist.id = obj["id"].toInt();
+        playlist.name = obj["name"].toString().trimmed();
+        if (playlist.name.isEmpty())
+            playlist.name = "Unnamed Playlist";
+        playlist.imageUrl = obj["imageUrl"].toString("");
+        playlist.userId = obj["userId"].toInt(0);
+        playlists.append(playlist);
+    }
+    return playlists;
+}
+
+void PlaylistModel::parseReplyAsync(const QByteArray &data, const QUrl &url, const QByteArray &validator, int playlistId)
+{
+    QString endpoint = url.path();
+    bool isSongList = endpoint.contains("/songs");
+    bool isSearch = endpoint.contains("/search");
+    // Parses finish in any order; only the latest request of each kind is applied
+    LatestReplyGuard *guard = isSearch ? (isSongList ? &m_songSearchRequests : &m_playlistSearchRequests)
+                                       : (isSongList ? &m_playlistSongRequests : &m_playlistRequests);
+    quint64 generation = guard->generation();
+
+    // Decoding runs on the global thread pool; only applying the result
+    // touches the GUI thread.
+    QFuture<ParsedReply> future = QtConcurrent::run([data, isSongList]()
+                                                    {
+        ParsedReply parsed;
+        if (isSongList)
+            parsed.songs = SongModel::parseSongs(data, &parsed.valid);
+        else
+            parsed.playlists = parsePlaylists(data, &parsed.valid);
+        return parsed; });
+
+    auto *watcher = new QFutureWatcher<ParsedReply>(this);
+    connect(watcher, &QFutureWatcher<ParsedReply>::finished, this, [this, watcher, guard, generation, isSongList, isSearch, url, validator, playlistId]()
+            {
+        watcher->deleteLater();
+        if (generation != guard->generation())
+        {
+            qDebug() << "PlaylistModel: Dropping parsed result of superseded request" << url.toString();
+            return;
+        }
+
+        ParsedReply parsed = watcher->result();
+        if (!parsed.valid)
+        {
+            emit errorOccurred("Invalid response format from server");
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        if (isSongList)
+            applySongs(parsed.songs, isSearch, url, validator, playlistId);
+        else
+            applyPlaylists(parsed.playlists, isSearch, url, validator);
+        setGuiBlockTimeUs(timer.nsecsElapsed() / 1000);
+        qDebug() << "PlaylistModel: Applied" << url.path() << "GUI thread blocked for" << m_guiBlockTimeUs << "us"; });
+    watcher->setFuture(future);
+}
+
+void PlaylistModel::applyPlaylists(const QList<PlaylistData> &playlists, bool isSearch, const QUrl &url, const QByteArray &validator)
+{
+    QString message;
+    if (isSearch)
+    {
+        message = playlists.isEmpty() ? "No playlists found" : "Playlists loaded successfully";
+        emit searchResultsLoaded(playlists, message);
+    }
+    else
+    {
+        applyRows(m_playlists, playlists, [](const PlaylistData &playlist) { return playlist.id; },
+                  [](const PlaylistData &a, const PlaylistData &b) { return !samePlaylist(a, b); });
+        m_playlistsUrl = url;
+        m_playlistsValidator = validator;
+        message = playlists.isEmpty() ? "No playlists available" : "Playlists loaded successfully";
+        emit playlistsChanged();
+    }
+}
+
+void PlaylistModel::applySongs(const QList<SongData> &songs, bool isSearch, const QUrl &url, const QByteArray &validator, int playlistId)
+{
+    QString message;
+    SongCatalog &catalog = SongCatalog::instance();
+    QSet<int> changedIds;
+    QList<int> songIds = catalog.insert(songs, &changedIds);
+    if (isSearch)
+    {
+        message = songs.isEmpty() ? "No songs found" : "Song search results loaded successfully";
+        m_searchSongModel->setSongs(songIds, changedIds);
+        emit songSearchResultsLoaded(playlistId, songIds, message);
+    }
+    else
+    {
+        message = songs.isEmpty() ? "No songs in this playlist" : "Songs loaded successfully";
+        catalog.retain(songIds);
+        QList<int> previous = m_currentSongs;
+        m_currentSongs = songIds;
+        m_currentSongsUrl = url;
+        m_currentSongsValidator = validator;
+        m_totalPages = m_currentSongs.count() > 0 ? (m_currentSongs.count() + m_itemsPerPage - 1) / m_itemsPerPage : 0;
+        if (m_currentPage >= m_totalPages && m_totalPages > 0)
+            m_currentPage = m_totalPages - 1;
+        else if (m_totalPages == 0)
+            m_currentPage = 0;
+        refreshPageSongs(previous, changedIds);
+        catalog.release(previous);
+        emit totalPagesChanged();
+        emit currentPageChanged();
+        emit songsLoaded(playlistId, m_currentSongs, message);
+    }
+}
+
+bool PlaylistModel::samePlaylist(const PlaylistData &a, const PlaylistData &b)
+{
+    if (a.name != b.name || a.imageUrl != b.imageUrl || a.userId != b.userId || a.songs.size() != b.songs.size())
+        return false;
+    for (int i = 0; i < a.songs.size(); ++i)
+        if (a.songs[i].id != b.songs[i].id)
+            return false;
+    return true;
+}
+
+void PlaylistModel::setGuiBlockTimeUs(qint64 us)
+{
+    if (m_guiBlockTimeUs != us)
+    {
+        m_guiBlockTimeUs = us;
+        emit guiBlockTimeUsChanged();
+    }
 }
 
 void PlaylistModel::handleNetworkReply(QNetworkReply *reply, int playlistId, int songId)
@@ -454,113 +706,35 @@ void PlaylistModel::handleNetworkReply(QNetworkReply *reply, int playlistId, int
     QString message;
     bool success = (reply->error() == QNetworkReply::NoError && httpStatus >= 200 && httpStatus < 300);
 
+    if (success && reply->operation() == QNetworkAccessManager::GetOperation)
+    {
+        if (HttpClient::isNotModified(reply, m_playlistsUrl, m_playlistsValidator))
+        {
+            qDebug() << "PlaylistModel: Playlists not modified, reusing" << m_playlists.count() << "parsed playlists";
+            emit playlistsChanged();
+            reply->deleteLater();
+            return;
+        }
+        if (HttpClient::isNotModified(reply, m_currentSongsUrl, m_currentSongsValidator))
+        {
+            qDebug() << "PlaylistModel: Playlist songs not modified, reusing" << m_currentSongs.count() << "parsed songs";
+            message = m_currentSongs.isEmpty() ? "No songs in this playlist" : "Songs loaded successfully";
+            emit songsLoaded(playlistId, m_currentSongs, message);
+            reply->deleteLater();
+            return;
+        }
+
+        parseReplyAsync(reply->readAll(), reply->url(), HttpClient::responseValidator(reply), playlistId);
+        reply->deleteLater();
+        return;
+    }
+
     if (success)
     {
         QByteArray responseData = reply->readAll();
         QJsonDocument doc = QJsonDocument::fromJson(responseData);
 
-        if (doc.isArray())
-        {
-            if (endpoint.contains("/playlists") && !endpoint.contains("/songs"))
-            {
-                QJsonArray jsonArray = doc.array();
-                QList<PlaylistData> playlists;
-                for (const QJsonValue &value : jsonArray)
-                {
-                    QJsonObject obj = value.toObject();
-                    PlaylistData playlist;
-                    playlist.id = obj["id"].toInt();
-                    playlist.name = obj["name"].toString().trimmed();
-                    if (playlist.name.isEmpty())
-                        playlist.name = "Unnamed Playlist";
-                    playlist.songs.clear();
-                    playlist.imageUrl = obj["imageUrl"].toString("");
-                    playlist.userId = obj["userId"].toInt(0);
-                    playlists.append(playlist);
-                }
-                if (endpoint.contains("/search"))
-                {
-                    message = playlists.isEmpty() ? "No playlists found" : "Playlists loaded successfully";
-                    emit searchResultsLoaded(playlists, message);
-                }
-                else
-                {
-                    beginResetModel();
-                    m_playlists = playlists;
-                    endResetModel();
-                    message = playlists.isEmpty() ? "No playlists available" : "Playlists loaded successfully";
-                    emit playlistsChanged();
-                }
-            }
-            else if (endpoint.contains("/songs"))
-            {
-                QJsonArray jsonArray = doc.array();
-                QList<SongData> songs;
-                for (const QJsonValue &value : jsonArray)
-                {
-                    QJsonObject obj = value.toObject();
-                    SongData song;
-                    song.id = obj["id"].toInt();
-                    song.title = obj["title"].toString().trimmed();
-                    if (song.title.isEmpty())
-                        song.title = "Unknown Title";
-
-                    QJsonValue artistsValue = obj["artists"];
-                    QStringList artists;
-                    if (artistsValue.isArray())
-                    {
-                        QJsonArray artistsArray = artistsValue.toArray();
-                        for (const QJsonValue &artist : artistsArray)
-                            if (!artist.toString().trimmed().isEmpty())
-                                artists.append(artist.toString().trimmed());
-                    }
-                    else if (artistsValue.isString())
-                    {
-                        QString artistsStr = artistsValue.toString().trimmed();
-                        if (!artistsStr.isEmpty())
-                            artists = artistsStr.split(",", Qt::SkipEmptyParts);
-                    }
-                    if (artists.isEmpty())
-                        artists.append("Unknown Artist");
-                    song.artists = artists;
-
-                    song.filePath = obj["file_path"].toString();
-                    if (song.filePath.isEmpty())
-                        song.filePath = "";
-
-                    QJsonArray genresArray = obj["genres"].toArray();
-                    QStringList genres;
-                    if (!genresArray.isEmpty())
-                        for (const QJsonValue &genre : genresArray)
-                            if (!genre.toString().trimmed().isEmpty())
-                                genres.append(genre.toString().trimmed());
-                    song.genres = genres;
-
-                    songs.append(song);
-                }
-                if (endpoint.contains("/search"))
-                {
-                    message = songs.isEmpty() ? "No songs found" : "Song search results loaded successfully";
-                    m_searchSongModel->setSongs(songs);
-                    emit songSearchResultsLoaded(playlistId, songs, message);
-                }
-                else
-                {
-                    message = songs.isEmpty() ? "No songs in this playlist" : "Songs loaded successfully";
-                    m_currentSongs = songs;
-                    m_totalPages = m_currentSongs.count() > 0 ? (m_currentSongs.count() + m_itemsPerPage - 1) / m_itemsPerPage : 0;
-                    if (m_currentPage >= m_totalPages && m_totalPages > 0)
-                        m_currentPage = m_totalPages - 1;
-                    else if (m_totalPages == 0)
-                        m_currentPage = 0;
-                    updatePageSongs();
-                    emit totalPagesChanged();
-                    emit currentPageChanged();
-                    emit songsLoaded(playlistId, songs, message);
-                }
-            }
-        }
-        else if (doc.isObject())
+        if (doc.isObject())
         {
             QJsonObject jsonObj = doc.object();
             message = jsonObj["message"].toString();
@@ -586,20 +760,21 @@ void PlaylistModel::handleNetworkReply(QNetworkReply *reply, int playlistId, int
             else if (endpoint.endsWith("/playlists/songs") && reply->operation() == QNetworkAccessManager::CustomOperation)
             {
                 emit songRemoved(playlistId, songId);
-                for (int i = 0; i < m_currentSongs.count(); ++i)
+                QList<int> previous = m_currentSongs;
+                int index = m_currentSongs.indexOf(songId);
+                if (index >= 0)
                 {
-                    if (m_currentSongs[i].id == songId)
-                    {
-                        m_currentSongs.removeAt(i);
-                        break;
-                    }
+                    m_currentSongs.removeAt(index);
+                    m_currentSongsValidator.clear();
                 }
                 m_totalPages = m_currentSongs.count() > 0 ? (m_currentSongs.count() + m_itemsPerPage - 1) / m_itemsPerPage : 0;
                 if (m_currentPage >= m_totalPages && m_totalPages > 0)
                     m_currentPage = m_totalPages - 1;
                 else if (m_totalPages == 0)
                     m_currentPage = 0;
-                updatePageSongs();
+                refreshPageSongs(previous, QSet<int>());
+                if (index >= 0)
+                    SongCatalog::instance().release({songId});
                 emit totalPagesChanged();
                 emit currentPageChanged();
             }
@@ -1,5 +1,5 @@
 #pragma once
-#include <QAbstractListModel>
+#include "KeyedListModel.hpp"
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QJsonDocument>
@@ -7,6 +7,7 @@
 #include <QJsonObject>
 #include <QSettings>
 #include "SongModel.hpp"
+#include "LatestReplyGuard.hpp"
 
 struct PlaylistData
 {
@@ -17,11 +18,12 @@ struct PlaylistData
     int userId;
 };
 
-class PageSongModel : public QAbstractListModel
+class PageSongModel : public KeyedListModel
 {
     Q_OBJECT
 public:
     explicit PageSongModel(QObject *parent = nullptr);
+    ~PageSongModel();
 
     enum SongRoles
     {
@@ -36,18 +38,31 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
-    Q_INVOKABLE void setSongs(const QList<SongData> &songs);
+    Q_INVOKABLE void setSongs(const QList<int> &songIds, const QSet<int> &changedIds = QSet<int>());
     Q_INVOKABLE void clear();
 
+    // Windowed mode: rows are songIds[offset, offset + length) of a list owned
+    // and kept alive by someone else; only the window bounds are stored here
+    void setSource(const QList<int> *songIds);
+    void setWindow(int offset, int length);
+    // After the owner replaced the source list; previous is its old contents
+    void sourceChanged(const QList<int> &previous, int offset, int length, const QSet<int> &changedIds);
+
 private:
-    QList<SongData> m_songs;
+    int moveWindow(const QList<int> *source, int offset, int length);
+
+    QList<int> m_songIds;
+    const QList<int> *m_source = nullptr;
+    int m_offset = 0;
+    int m_length = 0;
 };
 
-class PlaylistModel : public QAbstractListModel
+class PlaylistModel : public KeyedListModel
 {
     Q_OBJECT
     Q_PROPERTY(int count READ rowCount NOTIFY playlistsChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(qint64 guiBlockTimeUs READ guiBlockTimeUs NOTIFY guiBlockTimeUsChanged)
     Q_PROPERTY(int currentPage READ currentPage WRITE setCurrentPage NOTIFY currentPageChanged)
     Q_PROPERTY(int totalPages READ totalPages NOTIFY totalPagesChanged)
     Q_PROPERTY(int itemsPerPage READ itemsPerPage WRITE setItemsPerPage NOTIFY itemsPerPageChanged)
@@ -56,6 +71,7 @@ class PlaylistModel : public QAbstractListModel
 
 public:
     explicit PlaylistModel(QObject *parent = nullptr);
+    ~PlaylistModel();
 
     enum PlaylistRoles
     {
@@ -72,6 +88,9 @@ public:
 
     bool isLoading() const { return m_isLoading; }
     bool isAuthenticated() const;
+    qint64 guiBlockTimeUs() const { return m_guiBlockTimeUs; }
+
+    static QList<PlaylistData> parsePlaylists(const QByteArray &data, bool *ok = nullptr);
 
     int currentPage() const { return m_currentPage; }
     int totalPages() const { return m_totalPages; }
@@ -93,9 +112,9 @@ public:
 
 signals:
     void playlistsChanged();
-    void songsLoaded(int playlistId, const QList<SongData> &songs, const QString &message);
+    void songsLoaded(int playlistId, const QList<int> &songIds, const QString &message);
     void searchResultsLoaded(const QList<PlaylistData> &playlists, const QString &message);
-    void songSearchResultsLoaded(int playlistId, const QList<SongData> &songs, const QString &message);
+    void songSearchResultsLoaded(int playlistId, const QList<int> &songIds, const QString &message);
     void errorOccurred(const QString &error);
     void isLoadingChanged();
     void playlistCreated(int playlistId);
@@ -106,20 +125,42 @@ signals:
     void currentPageChanged();
     void totalPagesChanged();
     void itemsPerPageChanged();
+    void guiBlockTimeUsChanged();
 
 private slots:
     void handleNetworkReply(QNetworkReply *reply, int playlistId = 0, int songId = 0);
 
 private:
+    struct ParsedReply
+    {
+        bool valid = false;
+        QList<PlaylistData> playlists;
+        QList<SongData> songs;
+    };
+
+    void parseReplyAsync(const QByteArray &data, const QUrl &url, const QByteArray &validator, int playlistId);
+    void applyPlaylists(const QList<PlaylistData> &playlists, bool isSearch, const QUrl &url, const QByteArray &validator);
+    void applySongs(const QList<SongData> &songs, bool isSearch, const QUrl &url, const QByteArray &validator, int playlistId);
+    void setGuiBlockTimeUs(qint64 us);
     void updatePageSongs();
+    void refreshPageSongs(const QList<int> &previous, const QSet<int> &changedIds);
+    static bool samePlaylist(const PlaylistData &a, const PlaylistData &b);
     QList<PlaylistData> m_playlists;
-    QNetworkAccessManager m_networkManager;
+    QUrl m_playlistsUrl;
+    QByteArray m_playlistsValidator;
     QSettings *m_settings;
     bool m_isLoading = false;
+    qint64 m_guiBlockTimeUs = 0;
     int m_currentPage = 0;
     int m_totalPages = 0;
     int m_itemsPerPage = 25;
-    QList<SongData> m_currentSongs;
+    QList<int> m_currentSongs;
+    QUrl m_currentSongsUrl;
+    QByteArray m_currentSongsValidator;
     PageSongModel *m_pageSongModel;
     PageSongModel *m_searchSongModel;
+    LatestReplyGuard m_playlistRequests;
+    LatestReplyGuard m_playlistSongRequests;
+    LatestReplyGuard m_playlistSearchRequests;
+    LatestReplyGuard m_songSearchRequests;
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "ShuffleOrder.hpp"
+#include <QHash>
+
+ShuffleOrder::ShuffleOrder()
+    : m_random(QRandomGenerator::securelySeeded())
+{
+}
+
+void ShuffleOrder::setSeed(quint32 seed)
+{
+    m_random.seed(seed);
+}
+
+void ShuffleOrder::clearSeed()
+{
+    m_random = QRandomGenerator::securelySeeded();
+}
+
+void ShuffleOrder::clear()
+{
+    m_order.clear();
+    m_nextRound.clear();
+    m_position = -1;
+}
+
+void ShuffleOrder::shuffle(QList<int> &order, int first)
+{
+    // Fisher-Yates over order[first..]
+    for (int i = order.size() - 1; i > first; --i)
+        order.swapItemsAt(i, m_random.bounded(first, i + 1));
+}
+
+void ShuffleOrder::reset(const QList<int> &songIds, int currentSongId)
+{
+    m_order = songIds;
+    m_nextRound.clear();
+    m_position = -1;
+    shuffle(m_order, 0);
+
+    int index = currentSongId == -1 ? -1 : m_order.indexOf(currentSongId);
+    if (index != -1)
+    {
+        m_order.swapItemsAt(0, index);
+        m_position = 0;
+    }
+}
+
+void ShuffleOrder::update(const QList<int> &songIds)
+{
+    QHash<int, int> wanted;
+    wanted.reserve(songIds.size());
+    for (int songId : songIds)
+        ++wanted[songId];
+
+    // Keep entries the queue still holds, in order; the position follows the
+    // last kept entry at or before it, so a removed current song plays on
+    QList<int> kept;
+    kept.reserve(songIds.size());
+    int position = -1;
+    for (int i = 0; i < m_order.size(); ++i)
+    {
+        auto it = wanted.find(m_order[i]);
+        if (it == wanted.end() || it.value() == 0)
+            continue;
+        --it.value();
+        kept.append(m_order[i]);
+        if (i <= m_position)
+            position = kept.size() - 1;
+    }
+    m_order = kept;
+    m_position = position;
+    m_nextRound.clear();
+
+    // Inside-out Fisher-Yates for new ids. The song right after the current
+    // one stays put, since it may already be armed or prefetched.
+    int first = m_position + 2;
+    for (int songId : songIds)
+    {
+        auto it = wanted.find(songId);
+        if (it.value() == 0)
+            continue;
+        --it.value();
+        m_order.append(songId);
+        int last = m_order.size() - 1;
+        if (first < last)
+            m_order.swapItemsAt(last, m_random.bounded(first, last + 1));
+    }
+}
+
+int ShuffleOrder::peekNextRound(int lastSongId)
+{
+    if (m_nextRound.isEmpty())
+    {
+        m_nextRound = m_order;
+        shuffle(m_nextRound, 0);
+        if (m_nextRound.size() > 1 && m_nextRound.first() == lastSongId)
+            m_nextRound.swapItemsAt(0, m_random.bounded(1, int(m_nextRound.size())));
+    }
+    return m_nextRound.value(0, -1);
+}
+
+bool ShuffleOrder::setCurrent(int songId)
+{
+    if (next() == songId)
+    {
+        ++m_position;
+        return true;
+    }
+    if (current() == songId)
+        return true;
+    // The round peeked at the end of this one starts with its first song
+    if (next() == -1 && !m_nextRound.isEmpty() && m_nextRound.first() == songId)
+    {
+        m_order = m_nextRound;
+        m_nextRound.clear();
+        m_position = 0;
+        return true;
+    }
+    if (previous() == songId)
+    {
+        --m_position;
+        return true;
+    }
+
+    // Picked out of order: it becomes the next entry of the history
+    int index = m_order.indexOf(songId);
+    if (index == -1)
+        return false;
+    m_order.removeAt(index);
+    if (index <= m_position)
+        --m_position;
+    m_order.insert(++m_position, songId);
+    return true;
+}
\ No newline at end of file
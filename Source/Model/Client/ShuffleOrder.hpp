@@ -0,0 +1,46 @@
+#pragma once
+#include <QList>
+#include <QRandomGenerator>
+
+// Shuffled play order over the song ids of a queue. The order is a
+// Fisher-Yates permutation walked by a position: songs before it are the
+// history that previous() steps back through, songs after it are played
+// next, so nothing repeats until the whole queue has been played. Queue
+// edits are merged into the unplayed part without reshuffling it.
+class ShuffleOrder
+{
+public:
+    ShuffleOrder();
+
+    // A fixed seed makes the order reproducible, e.g. for benchmarks
+    void setSeed(quint32 seed);
+    void clearSeed();
+
+    // New permutation of songIds with currentSongId, if queued, as the played entry
+    void reset(const QList<int> &songIds, int currentSongId = -1);
+    // Keeps history and upcoming order; removed ids drop out, added ids
+    // are placed at random positions among the unplayed songs
+    void update(const QList<int> &songIds);
+    // First song of the round after this one, which does not repeat
+    // lastSongId first. The round is shuffled once and only replaces the
+    // order when setCurrent() gets that song, so history stays until then
+    int peekNextRound(int lastSongId);
+    // Records songId as playing; returns false if it is not in the order
+    bool setCurrent(int songId);
+    void clear();
+
+    int current() const { return m_order.value(m_position, -1); }
+    int next() const { return m_order.value(m_position + 1, -1); }
+    int previous() const { return m_position > 0 ? m_order[m_position - 1] : -1; }
+    QList<int> upcoming(int count) const { return m_order.mid(m_position + 1, count); }
+    bool isEmpty() const { return m_order.isEmpty(); }
+
+private:
+    void shuffle(QList<int> &order, int first);
+
+    QList<int> m_order;
+    int m_position = -1;
+    // Empty until peekNextRound()
+    QList<int> m_nextRound;
+    QRandomGenerator m_random;
+};
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "SongCatalog.hpp"
+#include "StringPool.hpp"
+#include <QDebug>
+
+SongCatalog &SongCatalog::instance()
+{
+    static SongCatalog instance;
+    return instance;
+}
+
+QList<int> SongCatalog::insert(const QList<SongData> &songs, QSet<int> *changedIds)
+{
+    QList<int> ids;
+    ids.reserve(songs.size());
+    m_entries.reserve(m_entries.size() + songs.size());
+    for (const SongData &song : songs)
+    {
+        if (insert(song) && changedIds)
+            changedIds->insert(song.id);
+        ids.append(song.id);
+    }
+    return ids;
+}
+
+bool SongCatalog::insert(const SongData &song)
+{
+    auto it = m_entries.find(song.id);
+    bool existed = it != m_entries.end();
+    if (!existed)
+        it = m_entries.insert(song.id, Entry());
+    Entry &entry = it.value();
+    bool sameFields = entry.title == song.title && entry.filePath == song.filePath;
+    entry.title = song.title;
+    entry.filePath = song.filePath;
+    if (existed && sameTags(entry, song))
+        return !sameFields;
+
+    m_deadTags += entry.artistCount + entry.genreCount;
+    entry.tagOffset = static_cast<quint32>(m_tagIds.size());
+    entry.artistCount = static_cast<quint16>(song.artistIds.size());
+    entry.genreCount = static_cast<quint16>(song.genreIds.size());
+    m_tagIds.append(song.artistIds);
+    m_tagIds.append(song.genreIds);
+
+    if (m_deadTags > 4096 && m_deadTags > m_tagIds.size() / 2)
+        compactTags();
+    return existed;
+}
+
+void SongCatalog::retain(const QList<int> &ids)
+{
+    for (int id : ids)
+    {
+        auto it = m_entries.find(id);
+        if (it != m_entries.end())
+            ++it->refs;
+    }
+}
+
+void SongCatalog::release(const QList<int> &ids)
+{
+    for (int id : ids)
+    {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end())
+            continue;
+        if (--it->refs <= 0)
+        {
+            m_deadTags += it->artistCount + it->genreCount;
+            m_entries.erase(it);
+        }
+    }
+    if (m_deadTags > 4096 && m_deadTags > m_tagIds.size() / 2)
+        compactTags();
+}
+
+SongData SongCatalog::song(int id) const
+{
+    SongData song;
+    song.id = id;
+    auto it = m_entries.constFind(id);
+    if (it == m_entries.constEnd())
+        return song;
+
+    song.title = it->title;
+    song.filePath = it->filePath;
+    const quint32 *tags = m_tagIds.constData() + it->tagOffset;
+    song.artistIds = QList<quint32>(tags, tags + it->artistCount);
+    song.genreIds = QList<quint32>(tags + it->artistCount, tags + it->artistCount + it->genreCount);
+    return song;
+}
+
+QString SongCatalog::title(int id) const
+{
+    auto it = m_entries.constFind(id);
+    return it != m_entries.constEnd() ? it->title : QString();
+}
+
+QString SongCatalog::filePath(int id) const
+{
+    auto it = m_entries.constFind(id);
+    return it != m_entries.constEnd() ? it->filePath : QString();
+}
+
+QStringList SongCatalog::artists(int id) const
+{
+    auto it = m_entries.constFind(id);
+    if (it == m_entries.constEnd())
+        return QStringList();
+    return StringPool::instance().values(m_tagIds.constData() + it->tagOffset, it->artistCount);
+}
+
+QStringList SongCatalog::genres(int id) const
+{
+    auto it = m_entries.constFind(id);
+    if (it == m_entries.constEnd())
+        return QStringList();
+    return StringPool::instance().values(m_tagIds.constData() + it->tagOffset + it->artistCount, it->genreCount);
+}
+
+QVariantMap SongCatalog::toVariantMap(int id) const
+{
+    QVariantMap map;
+    map["id"] = id;
+    map["title"] = title(id);
+    map["artists"] = artists(id);
+    map["file_path"] = filePath(id);
+    map["genres"] = genres(id);
+    return map;
+}
+
+qint64 SongCatalog::memoryUsage() const
+{
+    qint64 bytes = m_entries.capacity() * qint64(sizeof(int) + sizeof(Entry)) + m_tagIds.capacity() * qint64(sizeof(quint32));
+    for (const Entry &entry : m_entries)
+        bytes += (entry.title.capacity() + entry.filePath.capacity()) * qint64(sizeof(QChar));
+    return bytes;
+}
+
+bool SongCatalog::sameTags(const Entry &entry, const SongData &song) const
+{
+    if (entry.artistCount != song.artistIds.size() || entry.genreCount != song.genreIds.size())
+        return false;
+    const quint32 *tags = m_tagIds.constData() + entry.tagOffset;
+    for (int i = 0; i < entry.artistCount; ++i)
+        if (tags[i] != song.artistIds[i])
+            return false;
+    for (int i = 0; i < entry.genreCount; ++i)
+        if (tags[entry.artistCount + i] != song.genreIds[i])
+            return false;
+    return true;
+}
+
+void SongCatalog::compactTags()
+{
+    QList<quint32> compacted;
+    compacted.reserve(m_tagIds.size() - m_deadTags);
+    for (Entry &entry : m_entries)
+    {
+        quint32 offset = static_cast<quint32>(compacted.size());
+        const quint32 *tags = m_tagIds.constData() + entry.tagOffset;
+        for (int i = 0; i < entry.artistCount + entry.genreCount; ++i)
+            compacted.append(tags[i]);
+        entry.tagOffset = offset;
+    }
+    m_tagIds.swap(compacted);
+    m_deadTags = 0;
+    qDebug() << "SongCatalog: Compacted tag ids to" << m_tagIds.size() << "entries for" << m_entries.size() << "songs";
+}
\ No newline at end of file
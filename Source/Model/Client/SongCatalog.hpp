@@ -0,0 +1,52 @@
+#pragma once
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVariantMap>
+#include "SongModel.hpp"
+
+// Single source of truth for song records, keyed by song id. Models keep
+// only song ids and resolve fields here. Entries are reference counted by
+// the models holding their ids and dropped once no model does. Artist and
+// genre ids of all entries share one contiguous array.
+// Must only be used from the GUI thread.
+class SongCatalog
+{
+public:
+    static SongCatalog &instance();
+
+    // changedIds collects ids whose existing entry got different fields
+    QList<int> insert(const QList<SongData> &songs, QSet<int> *changedIds = nullptr);
+    bool insert(const SongData &song);
+    void retain(const QList<int> &ids);
+    void release(const QList<int> &ids);
+
+    bool contains(int id) const { return m_entries.contains(id); }
+    int count() const { return m_entries.count(); }
+    SongData song(int id) const;
+    QString title(int id) const;
+    QString filePath(int id) const;
+    QStringList artists(int id) const;
+    QStringList genres(int id) const;
+    QVariantMap toVariantMap(int id) const;
+    qint64 memoryUsage() const;
+
+private:
+    struct Entry
+    {
+        QString title;
+        QString filePath;
+        quint32 tagOffset = 0;
+        quint16 artistCount = 0;
+        quint16 genreCount = 0;
+        int refs = 0;
+    };
+
+    SongCatalog() = default;
+    bool sameTags(const Entry &entry, const SongData &song) const;
+    void compactTags();
+
+    QHash<int, Entry> m_entries;
+    QList<quint32> m_tagIds;
+    qsizetype m_deadTags = 0;
+};
\ No newline at end of file
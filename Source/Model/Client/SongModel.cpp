@@ -1,27 +1,78 @@
 #include "SongModel.hpp"
 #include "AppConfig.hpp"
+#include "HttpClient.hpp"
+#include "StringPool.hpp"
+#include "SongCatalog.hpp"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QUrlQuery>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QMetaObject>
 #include <QDebug>
 
+QStringList SongData::artists() const
+{
+    return StringPool::instance().values(artistIds.constData(), artistIds.size());
+}
+
+QStringList SongData::genres() const
+{
+    return StringPool::instance().values(genreIds.constData(), genreIds.size());
+}
+
 SongModel::SongModel(QObject *parent)
-    : QAbstractListModel(parent), m_networkManager(new QNetworkAccessManager(this))
+    : KeyedListModel(parent),
+      m_pageSize(AppConfig::instance().getSongPageSize()),
+      m_prefetchDistance(AppConfig::instance().getSongPrefetchDistance())
 {
+    m_streamPool.setMaxThreadCount(1);
+}
+
+SongModel::~SongModel()
+{
+    m_streamPool.clear();
+    m_streamPool.waitForDone();
+    discardPendingSongs();
+    SongCatalog::instance().release(m_songIds);
 }
 
 int SongModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return m_songs.count();
+    return m_songIds.count();
 }
 
 QVariant SongModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() >= m_songs.count())
+    if (index.row() < 0 || index.row() >= m_songIds.count())
         return QVariant();
-    const QMap<int, QVariant> &song = m_songs[index.row()];
-    return song.value(role);
+
+    // Ask for the next page while the view is still prefetchDistance rows away from the end
+    if (!m_prefetchScheduled && index.row() >= m_songIds.count() - m_prefetchDistance && canFetchMore(QModelIndex()))
+    {
+        m_prefetchScheduled = true;
+        QMetaObject::invokeMethod(const_cast<SongModel *>(this), "prefetchMore", Qt::QueuedConnection);
+    }
+
+    const SongCatalog &catalog = SongCatalog::instance();
+    int songId = m_songIds.at(index.row());
+    switch (role)
+    {
+    case IdRole:
+        return songId;
+    case TitleRole:
+        return catalog.title(songId);
+    case ArtistsRole:
+        return catalog.artists(songId);
+    case FilePathRole:
+        return catalog.filePath(songId);
+    case GenresRole:
+        return catalog.genres(songId);
+    default:
+        return QVariant();
+    }
 }
 
 QHash<int, QByteArray> SongModel::roleNames() const
@@ -35,6 +86,50 @@ QHash<int, QByteArray> SongModel::roleNames() const
     return roles;
 }
 
+bool SongModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_hasMore && !m_isLoading;
+}
+
+void SongModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+    qDebug() << "SongModel: Fetching next page at offset" << m_songIds.count();
+    requestSongPage(false);
+}
+
+void SongModel::prefetchMore()
+{
+    m_prefetchScheduled = false;
+    fetchMore(QModelIndex());
+}
+
+void SongModel::setPageSize(int pageSize)
+{
+    if (pageSize < 0 || m_pageSize == pageSize)
+        return;
+    m_pageSize = pageSize;
+    emit pageSizeChanged();
+}
+
+void SongModel::setPrefetchDistance(int distance)
+{
+    if (distance < 0 || m_prefetchDistance == distance)
+        return;
+    m_prefetchDistance = distance;
+    emit prefetchDistanceChanged();
+}
+
+void SongModel::setHasMore(bool hasMore)
+{
+    if (m_hasMore != hasMore)
+    {
+        m_hasMore = hasMore;
+        emit hasMoreChanged();
+    }
+}
+
 void SongModel::setQuery(const QString &query)
 {
     if (m_query == query)
@@ -59,6 +154,7 @@ void SongModel::searchSongs(const QString &query)
 
     m_isLoading = true;
     emit isLoadingChanged();
+    setHasMore(false);
 
     QUrl url(AppConfig::instance().getSongsSearchEndpoint());
     QUrlQuery queryParams;
@@ -66,11 +162,8 @@ void SongModel::searchSongs(const QString &query)
     url.setQuery(queryParams);
 
     QNetworkRequest request(url);
-    QString token = AppState::instance()->getToken();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
-
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_songRequests.start(reply);
     connect(reply, &QNetworkReply::finished, this, &SongModel::onSearchReply);
 }
 
@@ -82,19 +175,255 @@ void SongModel::fetchAllSongs()
         return;
     }
 
+    requestSongPage(true);
+}
+
+void SongModel::requestSongPage(bool reset)
+{
     m_isLoading = true;
     emit isLoadingChanged();
+    setHasMore(false);
 
     QUrl url(AppConfig::instance().getSongsEndpoint());
-    QNetworkRequest request(url);
-    QString token = AppState::instance()->getToken();
-    if (!token.isEmpty())
-        request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
+    if (m_pageSize > 0)
+    {
+        QUrlQuery queryParams;
+        queryParams.addQueryItem("limit", QString::number(m_pageSize));
+        queryParams.addQueryItem("offset", QString::number(reset ? 0 : m_songIds.count()));
+        url.setQuery(queryParams);
+    }
 
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkRequest request(url);
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    m_songRequests.start(reply);
+    m_songStream = QSharedPointer<JsonArrayStreamReader>::create();
+    m_songStreamStarted = !reset;
+    m_songStreamFed = false;
+    discardPendingSongs();
+    m_pageReset = reset;
+    m_pageRowCount = 0;
+    connect(reply, &QNetworkReply::readyRead, this, &SongModel::onFetchAllSongsReadyRead);
     connect(reply, &QNetworkReply::finished, this, &SongModel::onFetchAllSongsReply);
 }
 
+SongData SongModel::parseSong(const QJsonObject &obj)
+{
+    // Names are interned here, on the parser thread, so every model shares them
+    StringPool &pool = StringPool::instance();
+    SongData song;
+    song.id = obj["id"].toInt();
+    song.title = obj["title"].toString().trimmed();
+    if (song.title.isEmpty())
+        song.title = "Unknown Title";
+
+    QJsonValue artistsValue = obj["artists"];
+    if (artistsValue.isArray())
+    {
+        for (const QJsonValue &artist : artistsValue.toArray())
+        {
+            QString artistName = artist.toString().trimmed();
+            if (!artistName.isEmpty())
+                song.artistIds.append(pool.intern(artistName));
+        }
+    }
+    else if (artistsValue.isString())
+    {
+        for (const QString &artist : artistsValue.toString().split(",", Qt::SkipEmptyParts))
+        {
+            QString artistName = artist.trimmed();
+            if (!artistName.isEmpty())
+                song.artistIds.append(pool.intern(artistName));
+        }
+    }
+    if (song.artistIds.isEmpty())
+        song.artistIds.append(pool.intern("Unknown Artist"));
+
+    song.filePath = obj["file_path"].toString();
+
+    for (const QJsonValue &genre : obj["genres"].toArray())
+    {
+        QString genreName = genre.toString().trimmed();
+        if (!genreName.isEmpty())
+            song.genreIds.append(pool.intern(genreName));
+    }
+    return song;
+}
+
+QList<SongData> SongModel::parseSongs(const QByteArray &data, bool *ok)
+{
+    QList<SongData> songs;
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (ok)
+        *ok = doc.isArray();
+    if (!doc.isArray())
+        return songs;
+
+    QJsonArray jsonArray = doc.array();
+    songs.reserve(jsonArray.size());
+    for (const QJsonValue &value : jsonArray)
+        songs.append(parseSong(value.toObject()));
+    return songs;
+}
+
+
+void SongModel::parseSongsAsync(const QByteArray &data, const QUrl &url, const QByteArray &validator)
+{
+    // Decoding runs on the global thread pool; only the model swap below
+    // touches the GUI thread.
+    quint64 generation = m_songRequests.generation();
+    QFuture<ParsedSongs> future = QtConcurrent::run([data]()
+                                                    {
+        ParsedSongs parsed;
+        parsed.songs = parseSongs(data, &parsed.valid);
+        return parsed; });
+
+    auto *watcher = new QFutureWatcher<ParsedSongs>(this);
+    connect(watcher, &QFutureWatcher<ParsedSongs>::finished, this, [this, watcher, generation, url, validator]()
+            {
+        watcher->deleteLater();
+        if (generation != m_songRequests.generation())
+        {
+            qDebug() << "SongModel: Dropping parsed result of superseded request" << url.toString();
+            return;
+        }
+
+        ParsedSongs parsed = watcher->result();
+        if (!parsed.valid)
+        {
+            emit errorOccurred("Invalid response format from server");
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        QSet<int> changedIds;
+        setSongIds(SongCatalog::instance().insert(parsed.songs, &changedIds), changedIds);
+        m_songsUrl = url;
+        m_songsValidator = validator;
+        setGuiBlockTimeUs(timer.nsecsElapsed() / 1000);
+        qDebug() << "SongModel: Loaded" << m_songIds.count() << "songs from" << url.toString()
+                 << "GUI thread blocked for" << m_guiBlockTimeUs << "us";
+        emit songsChanged(); });
+    watcher->setFuture(future);
+}
+
+void SongModel::feedSongStream(const QByteArray &chunk, bool last, const QUrl &url, const QByteArray &validator)
+{
+    // Chunks are scanned and decoded in arrival order on a single worker
+    // thread; each decoded batch is queued back and appended as new rows.
+    quint64 generation = m_songRequests.generation();
+    QSharedPointer<JsonArrayStreamReader> reader = m_songStream;
+    m_streamPool.start([this, reader, chunk, last, generation, url, validator]()
+                       {
+        reader->feed(chunk);
+        QList<SongData> songs;
+        const QList<QByteArray> elements = reader->takeElements();
+        songs.reserve(elements.size());
+        for (const QByteArray &element : elements)
+            songs.append(parseSong(QJsonDocument::fromJson(element).object()));
+        if (!last && songs.isEmpty())
+            return;
+
+        bool valid = !last || reader->isComplete();
+        QMetaObject::invokeMethod(this, [this, songs, last, valid, generation, url, validator]()
+                                  { appendSongBatch(generation, songs, last, valid, url, validator); }, Qt::QueuedConnection); });
+}
+
+void SongModel::appendSongBatch(quint64 generation, const QList<SongData> &songs, bool last, bool valid, const QUrl &url, const QByteArray &validator)
+{
+    if (generation != m_songRequests.generation())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_songStreamStarted)
+    {
+        // Refreshing a populated list collects the page and diffs it in once
+        // complete; an empty list shows rows as they stream in
+        m_songStreamStarted = true;
+        m_diffingStream = !m_songIds.isEmpty();
+    }
+    if (!songs.isEmpty())
+    {
+        SongCatalog &catalog = SongCatalog::instance();
+        QList<int> ids = catalog.insert(songs, &m_pendingChangedIds);
+        catalog.retain(ids);
+        if (m_diffingStream)
+        {
+            m_pendingSongIds.append(ids);
+        }
+        else
+        {
+            int first = m_songIds.count();
+            beginInsertRows(QModelIndex(), first, first + ids.count() - 1);
+            m_songIds.append(ids);
+            endInsertRows();
+        }
+        m_pageRowCount += ids.count();
+    }
+    setGuiBlockTimeUs(timer.nsecsElapsed() / 1000);
+
+    if (!last)
+        return;
+
+    m_songStream.reset();
+    if (!valid)
+    {
+        discardPendingSongs();
+        emit errorOccurred("Invalid response format from server");
+        return;
+    }
+    if (m_diffingStream)
+    {
+        timer.restart();
+        setSongIds(m_pendingSongIds, m_pendingChangedIds);
+        setGuiBlockTimeUs(timer.nsecsElapsed() / 1000);
+    }
+    discardPendingSongs();
+    if (m_pageReset)
+    {
+        m_songsUrl = url;
+        m_songsValidator = validator;
+    }
+    // A short page is the last one; a page larger than requested means the server ignored paging
+    setHasMore(m_pageSize > 0 && m_pageRowCount == m_pageSize);
+    qDebug() << "SongModel: Streamed" << m_pageRowCount << "songs from" << url.toString() << "total:" << m_songIds.count();
+    emit songsChanged();
+}
+
+void SongModel::setSongIds(const QList<int> &ids, const QSet<int> &changedIds)
+{
+    // Retain the new ids before releasing the old ones so shared songs stay in the catalog
+    SongCatalog &catalog = SongCatalog::instance();
+    catalog.retain(ids);
+    QList<int> previous = m_songIds;
+    applyRows(m_songIds, ids, [](int id) { return id; },
+              [&changedIds](int id, int) { return changedIds.contains(id); });
+    catalog.release(previous);
+}
+
+void SongModel::discardPendingSongs()
+{
+    SongCatalog::instance().release(m_pendingSongIds);
+    m_pendingSongIds.clear();
+    m_pendingChangedIds.clear();
+    m_diffingStream = false;
+}
+
+qint64 SongModel::memoryUsage() const
+{
+    return SongCatalog::instance().memoryUsage() + m_songIds.capacity() * qint64(sizeof(int));
+}
+
+void SongModel::setGuiBlockTimeUs(qint64 us)
+{
+    if (m_guiBlockTimeUs != us)
+    {
+        m_guiBlockTimeUs = us;
+        emit guiBlockTimeUsChanged();
+    }
+}
+
 QString SongModel::getStreamUrl(int songId) const
 {
     return AppConfig::instance().getSongsStreamEndpoint(songId);
@@ -106,6 +435,13 @@ void SongModel::onSearchReply()
     if (!reply)
         return;
 
+    if (!m_songRequests.isCurrent(reply))
+    {
+        qDebug() << "SongModel::onSearchReply: Dropping superseded reply for" << reply->url().toString();
+        reply->deleteLater();
+        return;
+    }
+
     m_isLoading = false;
     emit isLoadingChanged();
 
@@ -114,65 +450,15 @@ void SongModel::onSearchReply()
 
     if (reply->error() == QNetworkReply::NoError && httpStatus >= 200 && httpStatus < 300)
     {
-        QByteArray responseData = reply->readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(responseData);
-        if (!doc.isArray())
+        if (HttpClient::isNotModified(reply, m_songsUrl, m_songsValidator))
         {
-            emit errorOccurred("Invalid response format from server");
+            qDebug() << "SongModel::onSearchReply: Not modified, reusing" << m_songIds.count() << "parsed songs";
+            emit songsChanged();
             reply->deleteLater();
             return;
         }
 
-        QJsonArray jsonArray = doc.array();
-        beginResetModel();
-        m_songs.clear();
-        for (const QJsonValue &value : jsonArray)
-        {
-            QJsonObject obj = value.toObject();
-            QMap<int, QVariant> song;
-            song[IdRole] = obj["id"].toInt();
-            QString title = obj["title"].toString().trimmed();
-            song[TitleRole] = title.isEmpty() ? "Unknown Title" : title;
-
-            QVariantList artists;
-            QJsonArray artistArray = obj["artists"].toArray();
-            if (artistArray.isEmpty())
-            {
-                artists.append(QVariant("Unknown Artist"));
-            }
-            else
-            {
-                for (const QJsonValue &artist : artistArray)
-                {
-                    QString artistName = artist.toString().trimmed();
-                    if (!artistName.isEmpty())
-                        artists.append(QVariant(artistName));
-                }
-            }
-            song[ArtistsRole] = artists;
-
-            song[FilePathRole] = obj["file_path"].toString();
-
-            QVariantList genres;
-            QJsonArray genreArray = obj["genres"].toArray();
-            for (const QJsonValue &genre : genreArray)
-            {
-                QString genreName = genre.toString().trimmed();
-                if (!genreName.isEmpty())
-                    genres.append(QVariant(genreName));
-            }
-            song[GenresRole] = genres;
-
-            m_songs.append(song);
-            qDebug() << "SongModel::onSearchReply: Parsed song - id:" << song[IdRole]
-                     << "title:" << song[TitleRole]
-                     << "artists:" << song[ArtistsRole]
-                     << "filePath:" << song[FilePathRole]
-                     << "genres:" << song[GenresRole];
-        }
-        endResetModel();
-        emit songsChanged();
-        message = m_songs.isEmpty() ? "No songs found" : "Songs loaded successfully";
+        parseSongsAsync(reply->readAll(), reply->url(), HttpClient::responseValidator(reply));
     }
     else
     {
@@ -216,12 +502,34 @@ void SongModel::onSearchReply()
     reply->deleteLater();
 }
 
+void SongModel::onFetchAllSongsReadyRead()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply || !m_songRequests.isCurrent(reply))
+        return;
+
+    // Error bodies and unchanged cached responses are left for onFetchAllSongsReply
+    int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (httpStatus < 200 || httpStatus >= 300 || HttpClient::isNotModified(reply, m_songsUrl, m_songsValidator))
+        return;
+
+    m_songStreamFed = true;
+    feedSongStream(reply->readAll(), false, reply->url(), HttpClient::responseValidator(reply));
+}
+
 void SongModel::onFetchAllSongsReply()
 {
     QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
     if (!reply)
         return;
 
+    if (!m_songRequests.isCurrent(reply))
+    {
+        qDebug() << "SongModel::onFetchAllSongsReply: Dropping superseded reply for" << reply->url().toString();
+        reply->deleteLater();
+        return;
+    }
+
     m_isLoading = false;
     emit isLoadingChanged();
 
@@ -230,65 +538,16 @@ void SongModel::onFetchAllSongsReply()
 
     if (reply->error() == QNetworkReply::NoError && httpStatus >= 200 && httpStatus < 300)
     {
-        QByteArray responseData = reply->readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(responseData);
-        if (!doc.isArray())
+        if (!m_songStreamFed && HttpClient::isNotModified(reply, m_songsUrl, m_songsValidator))
         {
-            emit errorOccurred("Invalid response format from server");
+            qDebug() << "SongModel::onFetchAllSongsReply: Not modified, reusing" << m_songIds.count() << "parsed songs";
+            setHasMore(m_pageSize > 0 && m_songIds.count() >= m_pageSize);
+            emit songsChanged();
             reply->deleteLater();
             return;
         }
 
-        QJsonArray jsonArray = doc.array();
-        beginResetModel();
-        m_songs.clear();
-        for (const QJsonValue &value : jsonArray)
-        {
-            QJsonObject obj = value.toObject();
-            QMap<int, QVariant> song;
-            song[IdRole] = obj["id"].toInt();
-            QString title = obj["title"].toString().trimmed();
-            song[TitleRole] = title.isEmpty() ? "Unknown Title" : title;
-
-            QVariantList artists;
-            QJsonArray artistArray = obj["artists"].toArray();
-            if (artistArray.isEmpty())
-            {
-                artists.append(QVariant("Unknown Artist"));
-            }
-            else
-            {
-                for (const QJsonValue &artist : artistArray)
-                {
-                    QString artistName = artist.toString().trimmed();
-                    if (!artistName.isEmpty())
-                        artists.append(QVariant(artistName));
-                }
-            }
-            song[ArtistsRole] = artists;
-
-            song[FilePathRole] = obj["file_path"].toString();
-
-            QVariantList genres;
-            QJsonArray genreArray = obj["genres"].toArray();
-            for (const QJsonValue &genre : genreArray)
-            {
-                QString genreName = genre.toString().trimmed();
-                if (!genreName.isEmpty())
-                    genres.append(QVariant(genreName));
-            }
-            song[GenresRole] = genres;
-
-            m_songs.append(song);
-            qDebug() << "SongModel::onFetchAllSongsReply: Parsed song - id:" << song[IdRole]
-                     << "title:" << song[TitleRole]
-                     << "artists:" << song[ArtistsRole]
-                     << "filePath:" << song[FilePathRole]
-                     << "genres:" << song[GenresRole];
-        }
-        endResetModel();
-        emit songsChanged();
-        message = m_songs.isEmpty() ? "No songs available" : "Songs loaded successfully";
+        feedSongStream(reply->readAll(), true, reply->url(), HttpClient::responseValidator(reply));
     }
     else
     {
@@ -1,30 +1,44 @@
 #pragma once
-#include <QAbstractListModel>
-#include <QNetworkAccessManager>
+#include <QSet>
+#include "KeyedListModel.hpp"
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
 #include "AppState.hpp"
+#include "LatestReplyGuard.hpp"
+#include "JsonArrayStreamReader.hpp"
+#include <QSharedPointer>
+#include <QThreadPool>
 
+// Artist and genre names are held as StringPool ids and only turned into
+// strings on demand, so every copy of a song shares one instance of each name.
 struct SongData
 {
     int id;
     QString title;
-    QStringList artists;
+    QList<quint32> artistIds;
     QString filePath;
-    QStringList genres;
+    QList<quint32> genreIds;
+
+    QStringList artists() const;
+    QStringList genres() const;
 };
 
-class SongModel : public QAbstractListModel
+class SongModel : public KeyedListModel
 {
     Q_OBJECT
     Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
     Q_PROPERTY(int count READ rowCount NOTIFY songsChanged)
     Q_PROPERTY(bool isLoading READ isLoading NOTIFY isLoadingChanged)
+    Q_PROPERTY(qint64 guiBlockTimeUs READ guiBlockTimeUs NOTIFY guiBlockTimeUsChanged)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged)
+    Q_PROPERTY(int prefetchDistance READ prefetchDistance WRITE setPrefetchDistance NOTIFY prefetchDistanceChanged)
+    Q_PROPERTY(bool hasMore READ hasMore NOTIFY hasMoreChanged)
 
 public:
     explicit SongModel(QObject *parent = nullptr);
+    ~SongModel();
 
     enum SongRoles
     {
@@ -38,29 +52,80 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
     QString query() const { return m_query; }
     void setQuery(const QString &query);
 
     bool isLoading() const { return m_isLoading; }
+    qint64 guiBlockTimeUs() const { return m_guiBlockTimeUs; }
+    // 0 fetches the whole list in one streamed request
+    int pageSize() const { return m_pageSize; }
+    void setPageSize(int pageSize);
+    int prefetchDistance() const { return m_prefetchDistance; }
+    void setPrefetchDistance(int distance);
+    bool hasMore() const { return m_hasMore; }
+    const QList<int> &songIds() const { return m_songIds; }
+
+    static SongData parseSong(const QJsonObject &obj);
+    static QList<SongData> parseSongs(const QByteArray &data, bool *ok = nullptr);
 
     Q_INVOKABLE void searchSongs(const QString &query);
     Q_INVOKABLE void fetchAllSongs();
     Q_INVOKABLE QString getStreamUrl(int songId) const;
+    Q_INVOKABLE qint64 memoryUsage() const;
 
 signals:
     void queryChanged();
     void songsChanged();
     void errorOccurred(const QString &error);
     void isLoadingChanged();
+    void guiBlockTimeUsChanged();
+    void pageSizeChanged();
+    void prefetchDistanceChanged();
+    void hasMoreChanged();
 
 private slots:
     void onSearchReply();
+    void onFetchAllSongsReadyRead();
     void onFetchAllSongsReply();
+    void prefetchMore();
 
 private:
+    struct ParsedSongs
+    {
+        bool valid = false;
+        QList<SongData> songs;
+    };
+
+    void parseSongsAsync(const QByteArray &data, const QUrl &url, const QByteArray &validator);
+    void requestSongPage(bool reset);
+    void setHasMore(bool hasMore);
+    void feedSongStream(const QByteArray &chunk, bool last, const QUrl &url, const QByteArray &validator);
+    void appendSongBatch(quint64 generation, const QList<SongData> &songs, bool last, bool valid, const QUrl &url, const QByteArray &validator);
+    void setSongIds(const QList<int> &ids, const QSet<int> &changedIds = QSet<int>());
+    void discardPendingSongs();
+    void setGuiBlockTimeUs(qint64 us);
+
     QString m_query;
-    QList<QMap<int, QVariant>> m_songs;
-    QNetworkAccessManager *m_networkManager;
+    QList<int> m_songIds;
+    QUrl m_songsUrl;
+    QByteArray m_songsValidator;
+    LatestReplyGuard m_songRequests;
+    QSharedPointer<JsonArrayStreamReader> m_songStream;
+    bool m_songStreamStarted = false;
+    bool m_songStreamFed = false;
+    bool m_diffingStream = false;
+    QList<int> m_pendingSongIds;
+    QSet<int> m_pendingChangedIds;
+    bool m_pageReset = true;
+    int m_pageRowCount = 0;
+    int m_pageSize;
+    int m_prefetchDistance;
+    bool m_hasMore = false;
+    mutable bool m_prefetchScheduled = false;
+    QThreadPool m_streamPool;
     bool m_isLoading = false;
+    qint64 m_guiBlockTimeUs = 0;
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QHash>
+#include "ListDiff.hpp"
+
+// List model base whose rows carry a unique int key. Refreshes go through
+// applyRows(), which turns the difference between the current and the new
+// rows into minimal insert/remove/move signals plus dataChanged for rows
+// whose content changed, so QML delegates and scroll position survive.
+class KeyedListModel : public QAbstractListModel
+{
+public:
+    using QAbstractListModel::QAbstractListModel;
+
+protected:
+    // keyOf(row) returns the row key; changed(oldRow, newRow) tells whether
+    // a kept row needs dataChanged. Falls back to a reset on duplicate keys
+    // and on reorders that would take more than ListDiff::MaxMoves moves.
+    template <typename T, typename KeyOf, typename Changed>
+    void applyRows(QList<T> &rows, const QList<T> &newRows, KeyOf keyOf, Changed changed)
+    {
+        QList<int> oldKeys;
+        QList<int> newKeys;
+        oldKeys.reserve(rows.size());
+        newKeys.reserve(newRows.size());
+        for (const T &row : rows)
+            oldKeys.append(keyOf(row));
+        for (const T &row : newRows)
+            newKeys.append(keyOf(row));
+
+        QList<ListDiff::Step> steps;
+        if (!ListDiff::compute(oldKeys, newKeys, &steps))
+        {
+            beginResetModel();
+            rows = newRows;
+            endResetModel();
+            return;
+        }
+
+        QList<int> changedRows;
+        {
+            QHash<int, int> oldIndex;
+            oldIndex.reserve(oldKeys.size());
+            for (int i = 0; i < oldKeys.size(); ++i)
+                oldIndex.insert(oldKeys[i], i);
+            for (int i = 0; i < newKeys.size(); ++i)
+            {
+                auto it = oldIndex.constFind(newKeys[i]);
+                if (it != oldIndex.constEnd() && changed(rows[it.value()], newRows[i]))
+                    changedRows.append(i);
+            }
+        }
+
+        for (const ListDiff::Step &step : steps)
+        {
+            switch (step.type)
+            {
+            case ListDiff::Step::Remove:
+                beginRemoveRows(QModelIndex(), step.first, step.last);
+                rows.remove(step.first, step.last - step.first + 1);
+                endRemoveRows();
+                break;
+            case ListDiff::Step::Move:
+                beginMoveRows(QModelIndex(), step.first, step.first, QModelIndex(), step.dest);
+                rows.move(step.first, step.dest > step.first ? step.dest - 1 : step.dest);
+                endMoveRows();
+                break;
+            case ListDiff::Step::Insert:
+                beginInsertRows(QModelIndex(), step.first, step.last);
+                for (int i = step.first; i <= step.last; ++i)
+                    rows.insert(i, newRows[i]);
+                endInsertRows();
+                break;
+            }
+        }
+
+        // Row order now matches; take the new contents and report changed runs
+        rows = newRows;
+        int i = 0;
+        while (i < changedRows.size())
+        {
+            int first = changedRows[i];
+            int last = first;
+            while (i + 1 < changedRows.size() && changedRows[i + 1] == last + 1)
+                last = changedRows[++i];
+            emit dataChanged(index(first), index(last));
+            ++i;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "ListDiff.hpp"
+#include <QHash>
+#include <QSet>
+
+namespace
+{
+    // Prefix counts over slots, O(log n) per update and query
+    class FenwickTree
+    {
+    public:
+        explicit FenwickTree(int size) : m_tree(size + 1, 0) {}
+
+        void add(int slot, int delta)
+        {
+            for (++slot; slot < m_tree.size(); slot += slot & -slot)
+                m_tree[slot] += delta;
+        }
+
+        // Sum over slots 0..slot-1
+        int countBefore(int slot) const
+        {
+            int sum = 0;
+            for (; slot > 0; slot -= slot & -slot)
+                sum += m_tree[slot];
+            return sum;
+        }
+
+    private:
+        QList<int> m_tree;
+    };
+}
+
+bool ListDiff::compute(const QList<int> &oldKeys, const QList<int> &newKeys, QList<Step> *steps)
+{
+    steps->clear();
+
+    QHash<int, int> newIndex;
+    newIndex.reserve(newKeys.size());
+    for (int i = 0; i < newKeys.size(); ++i)
+    {
+        if (newIndex.contains(newKeys[i]))
+            return false;
+        newIndex.insert(newKeys[i], i);
+    }
+    QSet<int> oldSet;
+    oldSet.reserve(oldKeys.size());
+    for (int key : oldKeys)
+    {
+        if (oldSet.contains(key))
+            return false;
+        oldSet.insert(key);
+    }
+
+    // Removals, back to front so earlier indices stay valid
+    int i = oldKeys.size() - 1;
+    while (i >= 0)
+    {
+        if (newIndex.contains(oldKeys[i]))
+        {
+            --i;
+            continue;
+        }
+        int last = i;
+        while (i >= 0 && !newIndex.contains(oldKeys[i]))
+            --i;
+        steps->append({Step::Remove, i + 1, last, -1});
+    }
+
+    QList<int> current;
+    QList<int> positions;
+    QHash<int, int> currentIndex;
+    current.reserve(oldKeys.size());
+    positions.reserve(oldKeys.size());
+    currentIndex.reserve(oldKeys.size());
+    for (int key : oldKeys)
+    {
+        auto it = newIndex.constFind(key);
+        if (it == newIndex.constEnd())
+            continue;
+        currentIndex.insert(key, current.size());
+        current.append(key);
+        positions.append(it.value());
+    }
+
+    // With unique keys the LCS of the kept rows is the longest run of
+    // increasing new positions; those rows never move
+    const QList<bool> stable = longestIncreasing(positions);
+    int stableCount = 0;
+    for (bool isStable : stable)
+        stableCount += isStable;
+    if (current.size() - stableCount > MaxMoves)
+    {
+        steps->clear();
+        return false;
+    }
+
+    // Every other kept row goes right before the next stable row in new order
+    // (-1: the end). Visiting them in new order keeps rows sharing an anchor
+    // correctly ordered.
+    QList<int> anchors(newKeys.size(), -1);
+    QList<int> movedCount(current.size() + 1, 0);
+    int anchor = -1;
+    for (int j = newKeys.size() - 1; j >= 0; --j)
+    {
+        auto it = currentIndex.constFind(newKeys[j]);
+        if (it == currentIndex.constEnd())
+            continue;
+        if (stable[it.value()])
+        {
+            anchor = it.value();
+            continue;
+        }
+        anchors[j] = anchor;
+        ++movedCount[anchor == -1 ? current.size() : anchor];
+    }
+
+    // Every row gets a slot in its final order up front: the rows moving in
+    // before a stable row come right before its slot. Counting occupied
+    // slots then gives any row's current index without moving a list.
+    QList<int> rowSlot(current.size());
+    QList<int> nextMovedSlot(current.size() + 1);
+    int slots = 0;
+    for (int j = 0; j <= current.size(); ++j)
+    {
+        nextMovedSlot[j] = slots;
+        slots += movedCount[j];
+        if (j < current.size())
+            rowSlot[j] = slots++;
+    }
+    FenwickTree occupied(slots);
+    for (int j = 0; j < current.size(); ++j)
+        occupied.add(rowSlot[j], 1);
+
+    for (int j = 0; j < newKeys.size(); ++j)
+    {
+        auto it = currentIndex.constFind(newKeys[j]);
+        if (it == currentIndex.constEnd() || stable[it.value()])
+            continue;
+        int row = it.value();
+        int target = nextMovedSlot[anchors[j] == -1 ? current.size() : anchors[j]]++;
+        int from = occupied.countBefore(rowSlot[row]);
+        int dest = occupied.countBefore(target);
+        occupied.add(rowSlot[row], -1);
+        occupied.add(target, 1);
+        rowSlot[row] = target;
+        if (dest == from || dest == from + 1)
+            continue;
+        steps->append({Step::Move, from, from, dest});
+    }
+
+    // Kept rows are now in new order, so added rows land at their new index
+    i = 0;
+    while (i < newKeys.size())
+    {
+        if (oldSet.contains(newKeys[i]))
+        {
+            ++i;
+            continue;
+        }
+        int first = i;
+        while (i < newKeys.size() && !oldSet.contains(newKeys[i]))
+            ++i;
+        steps->append({Step::Insert, first, i - 1, -1});
+    }
+    return true;
+}
+
+QList<bool> ListDiff::longestIncreasing(const QList<int> &values)
+{
+    // Patience sorting: tails[k] is the index ending the best run of length k + 1
+    QList<int> tails;
+    QList<int> previous(values.size(), -1);
+    for (int i = 0; i < values.size(); ++i)
+    {
+        int low = 0;
+        int high = tails.size();
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (values[tails[mid]] < values[i])
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low > 0)
+            previous[i] = tails[low - 1];
+        if (low == tails.size())
+            tails.append(i);
+        else
+            tails[low] = i;
+    }
+
+    QList<bool> inRun(values.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = previous[i])
+        inRun[i] = true;
+    return inRun;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <QList>
+
+// Computes the edit script that turns one list of unique int keys into
+// another. Kept keys that are part of the longest common subsequence stay
+// put, every other kept key costs exactly one move, and removed and added
+// keys are grouped into contiguous ranges. Row indices of every step are
+// valid at the time the step is applied, in order.
+class ListDiff
+{
+public:
+    struct Step
+    {
+        enum Type
+        {
+            Remove, // rows first..last
+            Move,   // row first to before row dest (beginMoveRows semantics)
+            Insert  // rows first..last, taken from the same range of the new list
+        };
+
+        Type type;
+        int first;
+        int last;
+        int dest;
+    };
+
+    // More moves than this cost more as signals than a reset does
+    static const int MaxMoves = 256;
+
+    // Returns false if either list contains a duplicate key or the script
+    // would need more than MaxMoves moves; the caller resets instead
+    static bool compute(const QList<int> &oldKeys, const QList<int> &newKeys, QList<Step> *steps);
+
+private:
+    static QList<bool> longestIncreasing(const QList<int> &values);
+};
\ No newline at end of file
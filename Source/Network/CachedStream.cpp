@@ -0,0 +1,138 @@
+#include "CachedStream.hpp"
+#include <QFile>
+#include <QThread>
+
+StreamProgress::StreamProgress(qint64 written, qint64 totalSize, QObject *parent)
+    : QObject(parent), m_written(written), m_totalSize(totalSize)
+{
+}
+
+qint64 StreamProgress::written() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_written;
+}
+
+qint64 StreamProgress::totalSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalSize;
+}
+
+bool StreamProgress::isFinished() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finished;
+}
+
+qint64 StreamProgress::waitFor(qint64 offset, const std::atomic<bool> &interrupted) const
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_written <= offset && !m_finished && !interrupted)
+        m_changed.wait(&m_mutex);
+    return m_written;
+}
+
+void StreamProgress::wakeAll()
+{
+    // Under the lock, so a reader between its check and its wait is not missed
+    QMutexLocker locker(&m_mutex);
+    m_changed.wakeAll();
+}
+
+void StreamProgress::restart(qint64 written, qint64 totalSize)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_written = written;
+        m_totalSize = totalSize;
+        m_finished = false;
+    }
+    emit advanced();
+}
+
+void StreamProgress::setTotalSize(qint64 totalSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_totalSize = totalSize;
+}
+
+void StreamProgress::advance(qint64 bytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_written += bytes;
+        m_changed.wakeAll();
+    }
+    emit advanced();
+}
+
+void StreamProgress::finish()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finished = true;
+        m_changed.wakeAll();
+    }
+    emit advanced();
+}
+
+CachedStream::CachedStream(const QString &filePath, const QSharedPointer<StreamProgress> &progress, QObject *parent)
+    : QIODevice(parent), m_file(new QFile(filePath, this)), m_progress(progress)
+{
+    connect(m_progress.data(), &StreamProgress::advanced, this, &QIODevice::readyRead);
+}
+
+qint64 CachedStream::size() const
+{
+    qint64 totalSize = m_progress->totalSize();
+    return totalSize >= 0 ? totalSize : m_progress->written();
+}
+
+qint64 CachedStream::bytesAvailable() const
+{
+    return qMax<qint64>(m_progress->written() - pos(), 0);
+}
+
+bool CachedStream::atEnd() const
+{
+    return m_progress->isFinished() && pos() >= m_progress->written();
+}
+
+bool CachedStream::isCached(qint64 offset) const
+{
+    return offset < m_progress->written();
+}
+
+void CachedStream::setInterrupted(bool interrupted)
+{
+    m_interrupted = interrupted;
+    if (interrupted)
+        m_progress->wakeAll();
+}
+
+qint64 CachedStream::readData(char *data, qint64 maxSize)
+{
+    qint64 position = pos();
+    // The stream's own thread must get back to its event loop for readyRead
+    qint64 written = QThread::currentThread() == thread() ? m_progress->written() : m_progress->waitFor(position, m_interrupted);
+    if (written <= position)
+        return m_interrupted || m_progress->isFinished() ? -1 : 0;
+
+    // The fill creates the file with its first bytes
+    if (!m_file->isOpen() && !m_file->open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        return -1;
+    if (m_file->pos() != position && !m_file->seek(position))
+        return -1;
+    qint64 read = m_file->read(data, qMin(maxSize, written - position));
+    if (read > 0 && !m_read.exchange(true))
+        emit firstBytesRead();
+    return read;
+}
+
+qint64 CachedStream::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include <QIODevice>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
+#include <atomic>
+
+class QFile;
+
+// How far the fill of one song has got, shared between StreamCache on the
+// GUI thread and the readers of the song's cache file on any thread
+class StreamProgress : public QObject
+{
+    Q_OBJECT
+public:
+    StreamProgress(qint64 written, qint64 totalSize, QObject *parent = nullptr);
+
+    qint64 written() const;
+    // -1 until the server reported it
+    qint64 totalSize() const;
+    // No fill is running; nothing past written() will arrive
+    bool isFinished() const;
+    // Blocks until more than offset bytes are written, the fill ends or
+    // interrupted is set, and returns the bytes written
+    qint64 waitFor(qint64 offset, const std::atomic<bool> &interrupted) const;
+    void wakeAll();
+
+    // A fill starts over from written, e.g. when the server ignored the range
+    void restart(qint64 written, qint64 totalSize);
+    void setTotalSize(qint64 totalSize);
+    void advance(qint64 bytes);
+    void finish();
+
+signals:
+    // Reaches readers on other threads queued, as their readyRead
+    void advanced();
+
+private:
+    mutable QMutex m_mutex;
+    mutable QWaitCondition m_changed;
+    qint64 m_written;
+    qint64 m_totalSize;
+    bool m_finished = false;
+};
+
+// Read-only view of a song's cache file while StreamCache fills it, so a
+// player consumes the fill's bytes instead of downloading the song again.
+// What is already on disk is served at once. A read past it waits for the
+// fill: on a reader thread of its own, such as a demuxer's, it blocks; on
+// the thread the stream lives on it returns nothing until readyRead.
+// Must be opened unbuffered.
+class CachedStream : public QIODevice
+{
+    Q_OBJECT
+public:
+    CachedStream(const QString &filePath, const QSharedPointer<StreamProgress> &progress, QObject *parent = nullptr);
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+    qint64 bytesAvailable() const override;
+    bool atEnd() const override;
+    // Reading from offset does not wait for the fill
+    bool isCached(qint64 offset) const;
+    qint64 cachedBytes() const { return m_progress->written(); }
+    // -1 until the server reported it
+    qint64 totalSize() const { return m_progress->totalSize(); }
+    // Ends a read blocked on the fill and fails the ones after it, so the
+    // decoder reading the stream can be stopped
+    void setInterrupted(bool interrupted);
+
+signals:
+    // Once, from the thread of the first read that returned data
+    void firstBytesRead();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    QFile *m_file;
+    QSharedPointer<StreamProgress> m_progress;
+    std::atomic<bool> m_interrupted{false};
+    std::atomic<bool> m_read{false};
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "HttpClient.hpp"
+#include "AppConfig.hpp"
+#include "AppState.hpp"
+#include <QUrl>
+#include <QNetworkDiskCache>
+#include <QStandardPaths>
+#include <QDebug>
+
+HttpClient *HttpClient::m_instance = nullptr;
+
+HttpClient::HttpClient(QObject *parent)
+    : QObject(parent), m_networkManager(new QNetworkAccessManager(this)), m_diskCache(new QNetworkDiskCache(this))
+{
+    m_diskCache->setMaximumCacheSize(AppConfig::instance().getHttpCacheMaxSize());
+    updateCacheDirectory();
+    m_networkManager->setCache(m_diskCache);
+    connect(AppState::instance(), &AppState::userIdChanged, this, &HttpClient::updateCacheDirectory);
+}
+
+void HttpClient::updateCacheDirectory()
+{
+    // Playlists and the catalog differ per account, so their responses never cross accounts
+    int userId = AppState::instance()->userId();
+    QString user = userId >= 0 ? QString::number(userId) : QStringLiteral("guest");
+    m_diskCache->setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http/" + user);
+}
+
+HttpClient *HttpClient::instance()
+{
+    if (!m_instance)
+    {
+        m_instance = new HttpClient();
+    }
+    return m_instance;
+}
+
+QNetworkRequest HttpClient::createRequest(const QUrl &url) const
+{
+    return prepareRequest(QNetworkRequest(url));
+}
+
+QNetworkRequest HttpClient::prepareRequest(const QNetworkRequest &request) const
+{
+    QNetworkRequest prepared(request);
+    prepared.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    if (!prepared.hasRawHeader("Authorization"))
+    {
+        QString token = AppState::instance()->getToken();
+        if (!token.isEmpty())
+            prepared.setRawHeader("Authorization", "Bearer " + token.toUtf8());
+    }
+    return prepared;
+}
+
+QNetworkReply *HttpClient::get(const QNetworkRequest &request)
+{
+    QNetworkRequest prepared = prepareRequest(request);
+    // Left to itself Qt serves Last-Modified responses without asking while
+    // they look fresh by heuristic, which hides changes the user just made.
+    // Going to the network with the cached validators gets a 304 instead,
+    // which Qt still answers from the cache.
+    if (!prepared.attribute(QNetworkRequest::CacheLoadControlAttribute).isValid())
+    {
+        QNetworkCacheMetaData metaData = m_diskCache->metaData(prepared.url());
+        if (metaData.isValid())
+        {
+            for (const QNetworkCacheMetaData::RawHeader &header : metaData.rawHeaders())
+            {
+                if (header.first.compare("ETag", Qt::CaseInsensitive) == 0)
+                    prepared.setRawHeader("If-None-Match", header.second);
+            }
+            if (metaData.lastModified().isValid())
+                prepared.setHeader(QNetworkRequest::IfModifiedSinceHeader, metaData.lastModified());
+        }
+        prepared.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    }
+    return track(m_networkManager->get(prepared), request);
+}
+
+QNetworkReply *HttpClient::post(const QNetworkRequest &request, const QByteArray &data)
+{
+    return track(m_networkManager->post(prepareRequest(request), data), request);
+}
+
+QNetworkReply *HttpClient::post(const QNetworkRequest &request, QHttpMultiPart *multiPart)
+{
+    return track(m_networkManager->post(prepareRequest(request), multiPart), request);
+}
+
+QNetworkReply *HttpClient::put(const QNetworkRequest &request, const QByteArray &data)
+{
+    return track(m_networkManager->put(prepareRequest(request), data), request);
+}
+
+QNetworkReply *HttpClient::deleteResource(const QNetworkRequest &request)
+{
+    return track(m_networkManager->deleteResource(prepareRequest(request)), request);
+}
+
+QNetworkReply *HttpClient::sendCustomRequest(const QNetworkRequest &request, const QByteArray &verb, const QByteArray &data)
+{
+    return track(m_networkManager->sendCustomRequest(prepareRequest(request), verb, data), request);
+}
+
+QNetworkReply *HttpClient::track(QNetworkReply *reply, const QNetworkRequest &request)
+{
+    // Background transfers (stream cache fills, prefetch) yield to requests the user is waiting on
+    if (request.attribute(BackgroundAttribute).toBool())
+        return reply;
+
+    if (m_foregroundRequests++ == 0)
+        emit foregroundBusyChanged(true);
+    connect(reply, &QNetworkReply::finished, this, [this]()
+            {
+        if (--m_foregroundRequests == 0)
+            emit foregroundBusyChanged(false); });
+    return reply;
+}
+
+void HttpClient::warmUp()
+{
+    QUrl baseUrl(AppConfig::instance().getBaseUrl());
+    if (!baseUrl.isValid() || baseUrl.host().isEmpty())
+        return;
+
+    if (baseUrl.scheme() == "https")
+        m_networkManager->connectToHostEncrypted(baseUrl.host(), baseUrl.port(443));
+    else
+        m_networkManager->connectToHost(baseUrl.host(), baseUrl.port(80));
+    qDebug() << "HttpClient: Warming up connection to" << baseUrl.host();
+}
+
+QByteArray HttpClient::responseValidator(const QNetworkReply *reply)
+{
+    QByteArray etag = reply->rawHeader("ETag");
+    if (!etag.isEmpty())
+        return etag;
+    return reply->rawHeader("Last-Modified");
+}
+
+bool HttpClient::isNotModified(const QNetworkReply *reply, const QUrl &url, const QByteArray &validator)
+{
+    // GETs always revalidate, so a response from the disk cache is a 304; if
+    // its validator matches the one the caller last parsed, the body is identical.
+    if (validator.isEmpty() || reply->url() != url)
+        return false;
+    if (!reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+        return false;
+    return responseValidator(reply) == validator;
+}
\ No newline at end of file
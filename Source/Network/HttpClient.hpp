@@ -0,0 +1,54 @@
+#pragma once
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QHttpMultiPart>
+
+class QNetworkDiskCache;
+
+// Process-wide HTTP client shared by every model. Owning a single
+// QNetworkAccessManager lets all requests to BASE_URL reuse the same pooled
+// (and, where the server supports it, HTTP/2 multiplexed) connections.
+// GET responses go through a disk cache, so repeated fetches are sent as
+// conditional requests (If-None-Match / If-Modified-Since). Cached bodies
+// are never served without asking the server first, so the cache only
+// saves the transfer, and each user gets a cache of their own.
+class HttpClient : public QObject
+{
+    Q_OBJECT
+public:
+    static HttpClient *instance();
+
+    // Set to true on requests that run in the background and must not count as busy
+    static const QNetworkRequest::Attribute BackgroundAttribute = QNetworkRequest::User;
+
+    QNetworkRequest createRequest(const QUrl &url) const;
+
+    QNetworkReply *get(const QNetworkRequest &request);
+    QNetworkReply *post(const QNetworkRequest &request, const QByteArray &data);
+    QNetworkReply *post(const QNetworkRequest &request, QHttpMultiPart *multiPart);
+    QNetworkReply *put(const QNetworkRequest &request, const QByteArray &data);
+    QNetworkReply *deleteResource(const QNetworkRequest &request);
+    QNetworkReply *sendCustomRequest(const QNetworkRequest &request, const QByteArray &verb, const QByteArray &data);
+
+    void warmUp();
+    bool isForegroundBusy() const { return m_foregroundRequests > 0; }
+
+    static QByteArray responseValidator(const QNetworkReply *reply);
+    static bool isNotModified(const QNetworkReply *reply, const QUrl &url, const QByteArray &validator);
+
+signals:
+    void foregroundBusyChanged(bool busy);
+
+private:
+    HttpClient(QObject *parent = nullptr);
+    QNetworkRequest prepareRequest(const QNetworkRequest &request) const;
+    QNetworkReply *track(QNetworkReply *reply, const QNetworkRequest &request);
+    void updateCacheDirectory();
+
+    static HttpClient *m_instance;
+    QNetworkAccessManager *m_networkManager;
+    QNetworkDiskCache *m_diskCache;
+    int m_foregroundRequests = 0;
+};
\ No newline at end of file
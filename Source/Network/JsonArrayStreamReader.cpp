@@ -0,0 +1,117 @@
+#include "JsonArrayStreamReader.hpp"
+
+static bool isJsonWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void JsonArrayStreamReader::feed(const QByteArray &chunk)
+{
+    const char *data = chunk.constData();
+    const qsizetype size = chunk.size();
+    qsizetype elementStart = 0;
+
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        const char c = data[i];
+        switch (m_state)
+        {
+        case State::BeforeArray:
+            // Tolerate a UTF-8 byte order mark ahead of the array
+            if (isJsonWhitespace(c) || c == '\xEF' || c == '\xBB' || c == '\xBF')
+                continue;
+            m_state = (c == '[') ? State::BetweenElements : State::Error;
+            break;
+
+        case State::BetweenElements:
+            if (isJsonWhitespace(c) || c == ',')
+                continue;
+            if (c == ']')
+            {
+                m_state = State::Done;
+                continue;
+            }
+            m_state = State::InElement;
+            m_element.clear();
+            elementStart = i;
+            m_depth = 0;
+            m_inString = false;
+            m_escape = false;
+            m_scalar = (c != '{' && c != '[' && c != '"');
+            if (m_scalar)
+                continue;
+            [[fallthrough]];
+
+        case State::InElement:
+            if (m_inString)
+            {
+                if (m_escape)
+                    m_escape = false;
+                else if (c == '\\')
+                    m_escape = true;
+                else if (c == '"')
+                {
+                    m_inString = false;
+                    if (m_depth == 0)
+                    {
+                        m_element.append(data + elementStart, i - elementStart + 1);
+                        finishElement();
+                    }
+                }
+            }
+            else if (m_scalar)
+            {
+                if (c == ',' || c == ']' || isJsonWhitespace(c))
+                {
+                    m_element.append(data + elementStart, i - elementStart);
+                    finishElement();
+                    if (c == ']')
+                        m_state = State::Done;
+                }
+            }
+            else if (c == '"')
+            {
+                m_inString = true;
+            }
+            else if (c == '{' || c == '[')
+            {
+                ++m_depth;
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (--m_depth == 0)
+                {
+                    m_element.append(data + elementStart, i - elementStart + 1);
+                    finishElement();
+                }
+            }
+            break;
+
+        case State::Done:
+            if (!isJsonWhitespace(c))
+                m_state = State::Error;
+            break;
+
+        case State::Error:
+            return;
+        }
+    }
+
+    // Keep the unfinished tail of the current element for the next chunk
+    if (m_state == State::InElement)
+        m_element.append(data + elementStart, size - elementStart);
+}
+
+QList<QByteArray> JsonArrayStreamReader::takeElements()
+{
+    QList<QByteArray> elements;
+    elements.swap(m_elements);
+    return elements;
+}
+
+void JsonArrayStreamReader::finishElement()
+{
+    m_elements.append(m_element);
+    m_element.clear();
+    m_state = State::BetweenElements;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+
+// Incremental reader for a top-level JSON array. Chunks are fed as they
+// arrive from the network and every complete element is returned as its own
+// small JSON document, so the full response never has to be held at once.
+class JsonArrayStreamReader
+{
+public:
+    void feed(const QByteArray &chunk);
+    QList<QByteArray> takeElements();
+
+    bool isComplete() const { return m_state == State::Done; }
+    bool hasError() const { return m_state == State::Error; }
+
+private:
+    enum class State
+    {
+        BeforeArray,
+        BetweenElements,
+        InElement,
+        Done,
+        Error
+    };
+
+    void finishElement();
+
+    State m_state = State::BeforeArray;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_scalar = false;
+    QByteArray m_element;
+    QList<QByteArray> m_elements;
+};
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "LatestReplyGuard.hpp"
+#include <QDebug>
+
+static const char *GenerationProperty = "requestGeneration";
+
+quint64 LatestReplyGuard::start(QNetworkReply *reply)
+{
+    // Bump the generation before aborting so the aborted reply's finished
+    // handler already sees itself as stale.
+    ++m_generation;
+    abortRunning();
+    m_reply = reply;
+    if (reply)
+        reply->setProperty(GenerationProperty, m_generation);
+    return m_generation;
+}
+
+bool LatestReplyGuard::isCurrent(const QNetworkReply *reply) const
+{
+    return reply && reply->property(GenerationProperty).toULongLong() == m_generation;
+}
+
+void LatestReplyGuard::cancel()
+{
+    ++m_generation;
+    abortRunning();
+}
+
+void LatestReplyGuard::abortRunning()
+{
+    QPointer<QNetworkReply> previous = m_reply;
+    m_reply.clear();
+    if (previous && previous->isRunning())
+    {
+        qDebug() << "LatestReplyGuard: Aborting superseded request" << previous->url().toString();
+        previous->abort();
+    }
+}
\ No newline at end of file
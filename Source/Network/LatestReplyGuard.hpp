@@ -0,0 +1,20 @@
+#pragma once
+#include <QNetworkReply>
+#include <QPointer>
+
+// Tracks the most recent reply of a request family (e.g. search) so that
+// superseded replies are aborted and their late results dropped unparsed.
+class LatestReplyGuard
+{
+public:
+    quint64 start(QNetworkReply *reply);
+    bool isCurrent(const QNetworkReply *reply) const;
+    void cancel();
+    quint64 generation() const { return m_generation; }
+
+private:
+    void abortRunning();
+
+    QPointer<QNetworkReply> m_reply;
+    quint64 m_generation = 0;
+};
\ No newline at end of file
@@ -0,0 +1,288 @@
+#include "SeekIndex.hpp"
+#include <QDataStream>
+#include <QIODevice>
+#include <algorithm>
+
+namespace
+{
+    const qint64 PointIntervalMs = 1000;
+    // Long enough for an ID3v2 tag header and any frame header
+    const int HeaderBytes = 10;
+    // Garbage this long without a frame means the stream is not MPEG audio
+    const qint64 MaxResyncBytes = 64 * 1024;
+    const int XingTocEntries = 100;
+
+    const int Bitrates[2][3][15] = {
+        // MPEG 1: layer I, II, III
+        {{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+         {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+         {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}},
+        // MPEG 2 and 2.5
+        {{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+         {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+         {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}}};
+    const int SampleRates[3] = {44100, 48000, 32000};
+
+    quint32 bigEndian32(const uchar *bytes)
+    {
+        return (quint32(bytes[0]) << 24) | (quint32(bytes[1]) << 16) | (quint32(bytes[2]) << 8) | quint32(bytes[3]);
+    }
+
+    quint16 bigEndian16(const uchar *bytes)
+    {
+        return quint16((bytes[0] << 8) | bytes[1]);
+    }
+}
+
+SeekIndex::Point SeekIndex::pointAt(qint64 timeMs) const
+{
+    if (m_points.isEmpty())
+        return Point();
+    auto after = std::upper_bound(m_points.constBegin(), m_points.constEnd(), timeMs, [](qint64 time, const Point &point)
+                                  { return time < point.timeMs; });
+    return after == m_points.constBegin() ? *after : *(after - 1);
+}
+
+QDataStream &operator<<(QDataStream &out, const SeekIndex &index)
+{
+    out << index.m_durationMs << qint32(index.m_points.size());
+    for (const SeekIndex::Point &point : index.m_points)
+        out << point.timeMs << point.byteOffset;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, SeekIndex &index)
+{
+    qint32 count = 0;
+    in >> index.m_durationMs >> count;
+    index.m_points.clear();
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        SeekIndex::Point point;
+        in >> point.timeMs >> point.byteOffset;
+        index.m_points.append(point);
+    }
+    return in;
+}
+
+void SeekIndexBuilder::add(const QByteArray &data)
+{
+    if (m_done)
+        return;
+    m_buffer.append(data);
+    while (!m_done)
+    {
+        qint64 offset = m_nextFrame - m_bufferStart;
+        if (offset >= m_buffer.size())
+        {
+            // The rest of a frame body; nothing in it is needed
+            m_bufferStart += m_buffer.size();
+            m_buffer.clear();
+            return;
+        }
+        const uchar *bytes = reinterpret_cast<const uchar *>(m_buffer.constData()) + offset;
+        if (step(bytes, int(m_buffer.size() - offset)) > 0)
+            break;
+    }
+    qint64 consumed = qMin<qint64>(m_nextFrame - m_bufferStart, m_buffer.size());
+    m_buffer.remove(0, consumed);
+    m_bufferStart += consumed;
+}
+
+void SeekIndexBuilder::scan(QIODevice *device)
+{
+    m_buffer.clear();
+    int needed = HeaderBytes;
+    while (!m_done && device->seek(m_nextFrame))
+    {
+        QByteArray bytes = device->read(needed);
+        int more = step(reinterpret_cast<const uchar *>(bytes.constData()), int(bytes.size()));
+        // More than the device has left
+        if (more > 0 && bytes.size() < more)
+            break;
+        needed = qMax(more, HeaderBytes);
+    }
+
+    // Chunks passed to add() afterwards continue from the end of device
+    m_bufferStart = qMin(m_nextFrame, device->size());
+    if (!m_done && device->seek(m_bufferStart))
+        m_buffer = device->readAll();
+}
+
+SeekIndex SeekIndexBuilder::finish() const
+{
+    SeekIndex index = m_index;
+    if (index.m_durationMs == 0 && m_sampleRate > 0)
+        index.m_durationMs = m_samples * 1000 / m_sampleRate;
+    return index;
+}
+
+int SeekIndexBuilder::step(const uchar *bytes, int available)
+{
+    if (!m_tagChecked)
+    {
+        if (available < HeaderBytes)
+            return HeaderBytes;
+        m_tagChecked = true;
+        if (m_nextFrame == 0 && bytes[0] == 'I' && bytes[1] == 'D' && bytes[2] == '3')
+        {
+            // ID3v2 size is syncsafe: 7 bits per byte; a footer adds 10 more
+            qint64 size = (qint64(bytes[6] & 0x7f) << 21) | ((bytes[7] & 0x7f) << 14) | ((bytes[8] & 0x7f) << 7) | (bytes[9] & 0x7f);
+            m_nextFrame = HeaderBytes + size + ((bytes[5] & 0x10) ? HeaderBytes : 0);
+            return 0;
+        }
+    }
+
+    if (available < 4)
+        return 4;
+    FrameHeader header;
+    if (!parseHeader(bytes, &header))
+    {
+        ++m_nextFrame;
+        if (++m_resyncBytes > MaxResyncBytes)
+            m_done = true;
+        return 0;
+    }
+    m_resyncBytes = 0;
+
+    if (m_firstFrame)
+    {
+        if (available < header.length)
+            return header.length;
+        m_firstFrame = false;
+        m_lockedBits = header.lockedBits;
+        m_sampleRate = header.sampleRate;
+        bool isTagFrame = false;
+        if (readTableOfContents(bytes, header, &isTagFrame))
+        {
+            m_done = true;
+            return 0;
+        }
+        // An encoder's Xing or Info frame is silent and skipped by decoders
+        if (isTagFrame)
+        {
+            m_nextFrame += header.length;
+            return 0;
+        }
+    }
+
+    qint64 timeMs = m_samples * 1000 / m_sampleRate;
+    if (timeMs >= m_nextPointMs)
+    {
+        m_index.m_points.append({timeMs, m_nextFrame});
+        m_nextPointMs = timeMs + PointIntervalMs;
+    }
+    m_samples += header.samples;
+    m_nextFrame += header.length;
+    return 0;
+}
+
+bool SeekIndexBuilder::parseHeader(const uchar *bytes, FrameHeader *header) const
+{
+    if (bytes[0] != 0xff || (bytes[1] & 0xe0) != 0xe0)
+        return false;
+    int version = (bytes[1] >> 3) & 0x03; // 0: 2.5, 1: reserved, 2: 2, 3: 1
+    int layer = (bytes[1] >> 1) & 0x03;   // 1: III, 2: II, 3: I
+    int bitrateIndex = bytes[2] >> 4;
+    int sampleRateIndex = (bytes[2] >> 2) & 0x03;
+    if (version == 1 || layer == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3)
+        return false;
+
+    // Version, layer and sample rate may not change within a stream, which
+    // keeps stray sync words in the audio data from passing as headers
+    quint32 lockedBits = bigEndian32(bytes) & 0xfffe0c00;
+    if (m_lockedBits != 0 && lockedBits != m_lockedBits)
+        return false;
+
+    header->mpeg1 = version == 3;
+    header->mono = (bytes[3] >> 6) == 3;
+    header->sampleRate = SampleRates[sampleRateIndex] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    header->lockedBits = lockedBits;
+    int layerIndex = 3 - layer; // 0: I, 1: II, 2: III
+    int bitrate = Bitrates[header->mpeg1 ? 0 : 1][layerIndex][bitrateIndex] * 1000;
+    int padding = (bytes[2] >> 1) & 0x01;
+    if (layerIndex == 0)
+    {
+        header->samples = 384;
+        header->length = (12 * bitrate / header->sampleRate + padding) * 4;
+    }
+    else
+    {
+        bool halfFrame = layerIndex == 2 && !header->mpeg1;
+        header->samples = halfFrame ? 576 : 1152;
+        header->length = (halfFrame ? 72 : 144) * bitrate / header->sampleRate + padding;
+    }
+    return header->length > 4;
+}
+
+bool SeekIndexBuilder::readTableOfContents(const uchar *frame, const FrameHeader &header, bool *isTagFrame)
+{
+    const qint64 frameOffset = m_nextFrame;
+    const int length = header.length;
+
+    // Xing (VBR) or Info (CBR) tag, right after the side information
+    int xing = 4 + (header.mpeg1 ? (header.mono ? 17 : 32) : (header.mono ? 9 : 17));
+    if (xing + 8 <= length && (std::equal(frame + xing, frame + xing + 4, "Xing") || std::equal(frame + xing, frame + xing + 4, "Info")))
+    {
+        *isTagFrame = true;
+        quint32 flags = bigEndian32(frame + xing + 4);
+        int position = xing + 8;
+        qint64 frames = 0;
+        qint64 bytes = -1;
+        if ((flags & 0x01) && position + 4 <= length)
+        {
+            frames = bigEndian32(frame + position);
+            position += 4;
+        }
+        if ((flags & 0x02) && position + 4 <= length)
+        {
+            bytes = bigEndian32(frame + position);
+            position += 4;
+        }
+        if (bytes <= 0 && m_totalSize > frameOffset)
+            bytes = m_totalSize - frameOffset;
+        if (!(flags & 0x04) || position + XingTocEntries > length || frames <= 0 || bytes <= 0)
+            return false;
+
+        // Entry i is where i percent of the song starts, in 256ths of its size
+        m_index.m_durationMs = frames * header.samples * 1000 / header.sampleRate;
+        for (int i = 0; i < XingTocEntries; ++i)
+        {
+            qint64 offset = frameOffset + frame[position + i] * bytes / 256;
+            if (!m_index.m_points.isEmpty() && offset < m_index.m_points.last().byteOffset)
+                offset = m_index.m_points.last().byteOffset;
+            m_index.m_points.append({m_index.m_durationMs * i / XingTocEntries, offset});
+        }
+        return true;
+    }
+
+    // VBRI tag, always 32 bytes after the header
+    const int vbri = 4 + 32;
+    if (vbri + 26 <= length && std::equal(frame + vbri, frame + vbri + 4, "VBRI"))
+    {
+        *isTagFrame = true;
+        qint64 frames = bigEndian32(frame + vbri + 14);
+        int entries = bigEndian16(frame + vbri + 18);
+        int scale = bigEndian16(frame + vbri + 20);
+        int entrySize = bigEndian16(frame + vbri + 22);
+        int framesPerEntry = bigEndian16(frame + vbri + 24);
+        int table = vbri + 26;
+        if (frames <= 0 || entries <= 0 || entrySize < 1 || entrySize > 4 || framesPerEntry <= 0 ||
+            table + entries * entrySize > length)
+            return false;
+
+        // Entries are the sizes of consecutive runs of frames after this one
+        m_index.m_durationMs = frames * header.samples * 1000 / header.sampleRate;
+        qint64 offset = frameOffset + length;
+        for (int i = 0; i < entries; ++i)
+        {
+            m_index.m_points.append({qint64(i) * framesPerEntry * header.samples * 1000 / header.sampleRate, offset});
+            quint32 size = 0;
+            for (int byte = 0; byte < entrySize; ++byte)
+                size = (size << 8) | frame[table + i * entrySize + byte];
+            offset += qint64(size) * scale;
+        }
+        return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+
+class QDataStream;
+class QIODevice;
+
+// Byte offsets of points in time within an MPEG audio stream, so a seek can
+// start reading at the right frame instead of at the beginning. Points from
+// a Xing or VBRI table of contents are approximate; points scanned from the
+// frame headers are exact frame starts.
+class SeekIndex
+{
+public:
+    struct Point
+    {
+        qint64 timeMs = 0;
+        qint64 byteOffset = 0;
+    };
+
+    bool isEmpty() const { return m_points.isEmpty(); }
+    qint64 durationMs() const { return m_durationMs; }
+    const QList<Point> &points() const { return m_points; }
+    // Last point at or before timeMs; the first point if there is none
+    Point pointAt(qint64 timeMs) const;
+
+    friend QDataStream &operator<<(QDataStream &out, const SeekIndex &index);
+    friend QDataStream &operator>>(QDataStream &in, SeekIndex &index);
+
+private:
+    friend class SeekIndexBuilder;
+
+    QList<Point> m_points;
+    qint64 m_durationMs = 0;
+};
+
+// Builds a SeekIndex from a stream front to back, either as it arrives in
+// chunks or by hopping from header to header through a file. A table of
+// contents in the first frame ends the work early; otherwise a point is
+// taken about every second of audio.
+class SeekIndexBuilder
+{
+public:
+    // Needed to place a Xing table that does not state the stream size
+    void setTotalSize(qint64 bytes) { m_totalSize = bytes; }
+    void add(const QByteArray &data);
+    // Reads only the frame headers of a file holding the stream from its
+    // start; add() may then go on with the bytes that follow the file
+    void scan(QIODevice *device);
+    bool isDone() const { return m_done; }
+    // Empty if no frames were found
+    SeekIndex finish() const;
+
+private:
+    struct FrameHeader
+    {
+        bool mpeg1 = false;
+        bool mono = false;
+        int sampleRate = 0;
+        int samples = 0;
+        int length = 0;
+        quint32 lockedBits = 0;
+    };
+
+    // Handles what starts at m_nextFrame; returns the bytes it needs there
+    // to go on, or 0 once it moved past them
+    int step(const uchar *bytes, int available);
+    bool parseHeader(const uchar *bytes, FrameHeader *header) const;
+    bool readTableOfContents(const uchar *frame, const FrameHeader &header, bool *isTagFrame);
+
+    SeekIndex m_index;
+    qint64 m_totalSize = -1;
+    qint64 m_nextFrame = 0;
+    qint64 m_bufferStart = 0;
+    QByteArray m_buffer;
+    bool m_tagChecked = false;
+    bool m_firstFrame = true;
+    bool m_done = false;
+    quint32 m_lockedBits = 0;
+    int m_sampleRate = 0;
+    qint64 m_samples = 0;
+    qint64 m_nextPointMs = 0;
+    qint64 m_resyncBytes = 0;
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "SeekIndexStore.hpp"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace
+{
+    const quint32 FileMagic = 0x534b4958; // "SKIX"
+    const quint32 FileVersion = 1;
+    const QString FileSuffix = ".skix";
+    // Indexes kept in memory; a few KB each
+    const int MemoryCacheCount = 32;
+    // Indexes kept on disk; a few MB in all
+    const int MaxStoredCount = 2000;
+}
+
+SeekIndexStore &SeekIndexStore::instance()
+{
+    static SeekIndexStore instance;
+    return instance;
+}
+
+SeekIndexStore::SeekIndexStore()
+    : m_directory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/seekindex"),
+      m_indexes(MemoryCacheCount)
+{
+    QDir().mkpath(m_directory);
+    // Written by versions that kept every index in one file
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/seekindex.dat");
+
+    // Only the names are read here; the indexes load when asked for
+    const QStringList names = QDir(m_directory).entryList({"*" + FileSuffix}, QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QString &name : names)
+    {
+        bool ok = false;
+        int songId = name.chopped(FileSuffix.size()).toInt(&ok);
+        if (ok && !m_stored.contains(songId))
+        {
+            m_stored.insert(songId);
+            m_order.append(songId);
+        }
+    }
+    while (m_order.size() > MaxStoredCount)
+        remove(m_order.first());
+    qDebug() << "SeekIndexStore: Found seek indexes of" << m_stored.size() << "songs";
+}
+
+SeekIndex SeekIndexStore::index(int songId)
+{
+    if (SeekIndex *index = m_indexes.object(songId))
+        return *index;
+    if (!m_stored.contains(songId))
+        return SeekIndex();
+
+    SeekIndex stored;
+    if (!load(songId, &stored))
+    {
+        remove(songId);
+        return SeekIndex();
+    }
+    m_indexes.insert(songId, new SeekIndex(stored));
+    return stored;
+}
+
+void SeekIndexStore::insert(int songId, const SeekIndex &index)
+{
+    if (index.isEmpty())
+        return;
+    save(songId, index);
+    m_indexes.insert(songId, new SeekIndex(index));
+    if (m_stored.contains(songId))
+        m_order.removeOne(songId);
+    m_stored.insert(songId);
+    m_order.append(songId);
+    while (m_order.size() > MaxStoredCount)
+        remove(m_order.first());
+}
+
+QString SeekIndexStore::filePath(int songId) const
+{
+    return m_directory + "/" + QString::number(songId) + FileSuffix;
+}
+
+bool SeekIndexStore::load(int songId, SeekIndex *index) const
+{
+    QFile file(filePath(songId));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != FileMagic || version != FileVersion)
+        return false;
+    in >> *index;
+    return in.status() == QDataStream::Ok && !index->isEmpty();
+}
+
+void SeekIndexStore::save(int songId, const SeekIndex &index) const
+{
+    QSaveFile file(filePath(songId));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << FileMagic << FileVersion << index;
+    file.commit();
+}
+
+void SeekIndexStore::remove(int songId)
+{
+    QFile::remove(filePath(songId));
+    m_indexes.remove(songId);
+    m_stored.remove(songId);
+    m_order.removeOne(songId);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <QCache>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include "SeekIndex.hpp"
+
+// Seek index of songs that were streamed once, one small binary file per
+// song, loaded when first asked for. Kept apart from the stream cache so
+// that evicted songs still seek with a single ranged request. Bounded by
+// song count; the oldest indexes go first.
+// Must only be used from the GUI thread.
+class SeekIndexStore
+{
+public:
+    static SeekIndexStore &instance();
+
+    bool contains(int songId) const { return m_stored.contains(songId); }
+    // Empty if the song has none
+    SeekIndex index(int songId);
+    void insert(int songId, const SeekIndex &index);
+
+private:
+    SeekIndexStore();
+    QString filePath(int songId) const;
+    // False if nothing valid is stored for the song
+    bool load(int songId, SeekIndex *index) const;
+    void save(int songId, const SeekIndex &index) const;
+    void remove(int songId);
+
+    QString m_directory;
+    QCache<int, SeekIndex> m_indexes;
+    QSet<int> m_stored;
+    // Stored songs, oldest first
+    QList<int> m_order;
+};
\ No newline at end of file
@@ -0,0 +1,489 @@
+#include "StreamCache.hpp"
+#include "CachedStream.hpp"
+#include "HttpClient.hpp"
+#include "AppConfig.hpp"
+#include "SeekIndex.hpp"
+#include "SeekIndexStore.hpp"
+#include <QBuffer>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+    const quint32 IndexMagic = 0x53434958; // "SCIX"
+    const quint32 IndexVersion = 1;
+    const int ThrottleIntervalMs = 100;
+    const qint64 ThrottleBufferSize = 64 * 1024;
+}
+
+StreamCache *StreamCache::m_instance = nullptr;
+
+StreamCache::StreamCache(QObject *parent)
+    : QObject(parent),
+      m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/streams"),
+      m_maximumSize(AppConfig::instance().getStreamCacheMaxSize()),
+      m_throttleTimer(new QTimer(this))
+{
+    m_throttleTimer->setInterval(ThrottleIntervalMs);
+    connect(m_throttleTimer, &QTimer::timeout, this, &StreamCache::onThrottleTick);
+    QDir().mkpath(m_directory);
+    loadIndex();
+    evict();
+}
+
+StreamCache *StreamCache::instance()
+{
+    if (!m_instance)
+    {
+        m_instance = new StreamCache();
+    }
+    return m_instance;
+}
+
+QUrl StreamCache::playbackUrl(int songId, const QUrl &streamUrl)
+{
+    touch(songId);
+    if (isComplete(songId))
+    {
+        qDebug() << "StreamCache: Playing song" << songId << "from cache";
+        if (!SeekIndexStore::instance().contains(songId))
+            indexCachedFile(songId);
+        return QUrl::fromLocalFile(filePath(songId));
+    }
+    return streamUrl;
+}
+
+CachedStream *StreamCache::openStream(int songId, const QUrl &streamUrl)
+{
+    if (isComplete(songId))
+        return nullptr;
+    fill(songId, streamUrl);
+
+    QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef();
+    if (!progress)
+    {
+        // A prefetch fill may still hold bytes in its write buffer
+        auto running = m_fills.constFind(songId);
+        if (running != m_fills.constEnd() && running->file)
+            running->file->flush();
+        const Entry &entry = m_entries[songId];
+        // Deleted on the GUI thread, whichever thread drops the last stream
+        progress = QSharedPointer<StreamProgress>(new StreamProgress(entry.cachedBytes, entry.totalSize), &QObject::deleteLater);
+        m_progress.insert(songId, progress);
+        // A fill that already ended would never finish it
+        if (!m_fills.contains(songId))
+            progress->finish();
+    }
+    CachedStream *stream = new CachedStream(filePath(songId), progress);
+    stream->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    qDebug() << "StreamCache: Streaming song" << songId << "from cache," << progress->written() << "bytes on disk";
+    return stream;
+}
+
+void StreamCache::fill(int songId, const QUrl &streamUrl, bool throttled)
+{
+    auto running = m_fills.find(songId);
+    if (running != m_fills.end())
+    {
+        // Playback wants a song that is being prefetched; lift its limit
+        if (running->throttled && !throttled && running->reply)
+        {
+            running->throttled = false;
+            running->reply->setReadBufferSize(0);
+            pull(songId, running->reply, -1);
+        }
+        return;
+    }
+    if (isComplete(songId))
+        return;
+
+    Entry &entry = m_entries[songId];
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+
+    QNetworkRequest request = HttpClient::instance()->createRequest(streamUrl);
+    // Stream bodies are kept here, not in the shared HTTP cache
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setAttribute(HttpClient::BackgroundAttribute, true);
+    if (entry.cachedBytes > 0)
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(entry.cachedBytes) + "-");
+
+    QNetworkReply *reply = HttpClient::instance()->get(request);
+    reply->setProperty("songId", songId);
+    Fill &fill = m_fills[songId];
+    fill.reply = reply;
+    fill.throttled = throttled;
+    if (throttled)
+    {
+        // A small read buffer lets TCP flow control hold the sender to our read rate
+        reply->setReadBufferSize(ThrottleBufferSize);
+        m_throttleTimer->start();
+    }
+    connect(reply, &QNetworkReply::readyRead, this, &StreamCache::onFillReadyRead);
+    connect(reply, &QNetworkReply::finished, this, &StreamCache::onFillFinished);
+    if (QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef())
+        progress->restart(entry.cachedBytes, entry.totalSize);
+    qDebug() << "StreamCache: Filling song" << songId << "from byte" << entry.cachedBytes;
+}
+
+void StreamCache::cancel(int songId)
+{
+    auto it = m_fills.find(songId);
+    if (it != m_fills.end() && it->reply)
+        it->reply->abort();
+}
+
+bool StreamCache::isComplete(int songId) const
+{
+    auto it = m_entries.constFind(songId);
+    return it != m_entries.constEnd() && it->totalSize >= 0 && it->cachedBytes >= it->totalSize;
+}
+
+QString StreamCache::localFile(int songId) const
+{
+    return isComplete(songId) ? filePath(songId) : QString();
+}
+
+QList<int> StreamCache::completeSongIds() const
+{
+    QList<int> songIds;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        if (isComplete(it.key()))
+            songIds.append(it.key());
+    return songIds;
+}
+
+qint64 StreamCache::cachedBytes(int songId) const
+{
+    return m_entries.value(songId).cachedBytes;
+}
+
+void StreamCache::setThrottle(qint64 bytesPerSecond)
+{
+    m_throttleRate = qMax<qint64>(bytesPerSecond, 0);
+}
+
+void StreamCache::setThrottlePaused(bool paused)
+{
+    m_throttlePaused = paused;
+}
+
+void StreamCache::onFillReadyRead()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply)
+        return;
+    int songId = reply->property("songId").toInt();
+    auto it = m_fills.find(songId);
+    if (it == m_fills.end() || it->reply != reply || it->throttled)
+        return;
+    pull(songId, reply, -1);
+}
+
+void StreamCache::onThrottleTick()
+{
+    QList<int> throttled;
+    for (auto it = m_fills.constBegin(); it != m_fills.constEnd(); ++it)
+        if (it->throttled)
+            throttled.append(it.key());
+    if (throttled.isEmpty())
+    {
+        m_throttleTimer->stop();
+        return;
+    }
+    if (m_throttlePaused)
+        return;
+
+    // An unlimited rate still reads through the timer, one buffer per tick
+    qint64 budget = m_throttleRate > 0 ? m_throttleRate * ThrottleIntervalMs / 1000 / throttled.size() : ThrottleBufferSize;
+    for (int songId : throttled)
+    {
+        auto it = m_fills.constFind(songId);
+        if (it != m_fills.constEnd() && it->reply)
+            pull(songId, it->reply, qMax<qint64>(budget, 1));
+    }
+}
+
+void StreamCache::pull(int songId, QNetworkReply *reply, qint64 maxBytes)
+{
+    auto it = m_fills.find(songId);
+    // The throttle timer and a lifted throttle read without waiting for readyRead
+    if (!it->accepted && !reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid())
+        return;
+    if (!it->accepted && !acceptResponse(songId, reply, *it))
+    {
+        reply->abort();
+        return;
+    }
+
+    QByteArray chunk = maxBytes < 0 ? reply->readAll() : reply->read(maxBytes);
+    if (chunk.isEmpty())
+        return;
+    QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef();
+    // Open streams read the file, so their bytes must leave the write buffer
+    if (it->file->write(chunk) != chunk.size() || (progress && !it->file->flush()))
+    {
+        qDebug() << "StreamCache: Write failed for song" << songId << it->file->errorString();
+        reply->abort();
+        return;
+    }
+    if (it->seekIndex)
+        it->seekIndex->add(chunk);
+    m_entries[songId].cachedBytes += chunk.size();
+    m_totalBytes += chunk.size();
+    if (progress)
+        progress->advance(chunk.size());
+    if (m_totalBytes > m_maximumSize)
+        evict();
+}
+
+void StreamCache::onFillFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply)
+        return;
+    reply->deleteLater();
+    int songId = reply->property("songId").toInt();
+    auto it = m_fills.find(songId);
+    if (it == m_fills.end() || it->reply != reply)
+        return;
+
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() == QNetworkReply::NoError)
+        pull(songId, reply, -1);
+
+    Fill fill = m_fills.take(songId);
+    if (fill.file)
+    {
+        fill.file->close();
+        delete fill.file;
+    }
+    // Readers take what is on disk as the whole song until a fill resumes
+    if (QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef())
+        progress->finish();
+    else
+        m_progress.remove(songId);
+
+    auto entry = m_entries.find(songId);
+    if (entry == m_entries.end())
+    {
+        delete fill.seekIndex;
+        emit fillFinished(songId);
+        return;
+    }
+    if (statusCode == 416)
+    {
+        // Nothing left past our offset; either we already hold the whole song or the file changed
+        if (entry->totalSize < 0 || entry->cachedBytes != entry->totalSize)
+            remove(songId);
+    }
+    else if (reply->error() == QNetworkReply::NoError && fill.accepted && entry->totalSize < 0)
+    {
+        entry->totalSize = entry->cachedBytes;
+    }
+    else if (reply->error() != QNetworkReply::NoError)
+    {
+        qDebug() << "StreamCache: Fill of song" << songId << "stopped at" << entry->cachedBytes << "bytes:" << reply->errorString();
+    }
+
+    entry = m_entries.find(songId);
+    if (entry != m_entries.end() && entry->cachedBytes == 0 && entry->totalSize < 0)
+        m_entries.erase(entry);
+
+    // A fill that stopped early builds its index again when it resumes
+    if (fill.seekIndex && isComplete(songId))
+        SeekIndexStore::instance().insert(songId, fill.seekIndex->finish());
+    delete fill.seekIndex;
+
+    if (isComplete(songId))
+    {
+        qDebug() << "StreamCache: Song" << songId << "fully cached," << m_totalBytes << "bytes in cache";
+        emit songCached(songId);
+    }
+    saveIndex();
+    emit fillFinished(songId);
+}
+
+bool StreamCache::acceptResponse(int songId, QNetworkReply *reply, Fill &fill)
+{
+    Entry &entry = m_entries[songId];
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QIODevice::OpenMode mode = QIODevice::ReadWrite;
+    if (statusCode == 206)
+    {
+        // Content-Range: bytes <first>-<last>/<total or *>
+        QByteArray range = reply->rawHeader("Content-Range");
+        int space = range.indexOf(' ');
+        int dash = range.indexOf('-', space);
+        int slash = range.indexOf('/', dash);
+        if (space < 0 || dash < 0 || slash < 0 || range.mid(space + 1, dash - space - 1).toLongLong() != entry.cachedBytes)
+        {
+            qDebug() << "StreamCache: Unexpected Content-Range for song" << songId << range;
+            return false;
+        }
+        bool ok = false;
+        qint64 total = range.mid(slash + 1).toLongLong(&ok);
+        entry.totalSize = ok ? total : -1;
+        if (QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef())
+            progress->setTotalSize(entry.totalSize);
+    }
+    else if (statusCode == 200)
+    {
+        // Server ignored the range and sent the whole song; start over
+        m_totalBytes -= entry.cachedBytes;
+        entry.cachedBytes = 0;
+        qint64 length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        entry.totalSize = length > 0 ? length : -1;
+        mode = QIODevice::WriteOnly | QIODevice::Truncate;
+        // Readers past the start wait until the new body gets back to them
+        if (QSharedPointer<StreamProgress> progress = m_progress.value(songId).toStrongRef())
+            progress->restart(0, entry.totalSize);
+    }
+    else
+    {
+        return false;
+    }
+
+    fill.file = new QFile(filePath(songId));
+    if (!fill.file->open(mode))
+    {
+        qDebug() << "StreamCache: Cannot open cache file for song" << songId << fill.file->errorString();
+        delete fill.file;
+        fill.file = nullptr;
+        return false;
+    }
+    // Drop anything past the recorded length, e.g. bytes written just before a crash
+    fill.file->resize(entry.cachedBytes);
+    fill.file->seek(entry.cachedBytes);
+    fill.accepted = true;
+    startSeekIndex(songId, fill);
+    return true;
+}
+
+void StreamCache::startSeekIndex(int songId, Fill &fill)
+{
+    if (SeekIndexStore::instance().contains(songId))
+        return;
+    fill.seekIndex = new SeekIndexBuilder();
+    fill.seekIndex->setTotalSize(m_entries[songId].totalSize);
+    // A resumed fill first walks the headers of what is already on disk
+    if (m_entries[songId].cachedBytes > 0)
+    {
+        QFile file(filePath(songId));
+        if (file.open(QIODevice::ReadOnly))
+            fill.seekIndex->scan(&file);
+    }
+}
+
+QString StreamCache::filePath(int songId) const
+{
+    return m_directory + "/" + QString::number(songId) + ".stream";
+}
+
+void StreamCache::indexCachedFile(int songId)
+{
+    // Songs cached before they got an index while filling; hopping from
+    // header to header through the mapped file takes a few milliseconds
+    QFile file(filePath(songId));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    uchar *data = file.map(0, file.size());
+    if (!data)
+        return;
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), file.size());
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    SeekIndexBuilder builder;
+    builder.setTotalSize(file.size());
+    builder.scan(&buffer);
+    SeekIndexStore::instance().insert(songId, builder.finish());
+}
+
+void StreamCache::touch(int songId)
+{
+    auto it = m_entries.find(songId);
+    if (it != m_entries.end())
+        it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+}
+
+void StreamCache::evict()
+{
+    if (m_totalBytes <= m_maximumSize)
+        return;
+
+    QList<int> order = m_entries.keys();
+    std::sort(order.begin(), order.end(), [this](int a, int b)
+              { return m_entries[a].lastUsed < m_entries[b].lastUsed; });
+    for (int songId : order)
+    {
+        if (m_totalBytes <= m_maximumSize)
+            break;
+        // Songs being filled are in use by playback or prefetch
+        if (m_fills.contains(songId))
+            continue;
+        remove(songId);
+    }
+    saveIndex();
+}
+
+void StreamCache::remove(int songId)
+{
+    auto it = m_entries.find(songId);
+    if (it == m_entries.end())
+        return;
+    m_totalBytes -= it->cachedBytes;
+    m_entries.erase(it);
+    QFile::remove(filePath(songId));
+    qDebug() << "StreamCache: Evicted song" << songId;
+}
+
+void StreamCache::loadIndex()
+{
+    QFile file(m_directory + "/index.dat");
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != IndexMagic || version != IndexVersion || count < 0)
+        return;
+
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        qint32 songId = 0;
+        Entry entry;
+        in >> songId >> entry.cachedBytes >> entry.totalSize >> entry.lastUsed;
+        // The data file is the truth for how much was written before a crash
+        QFileInfo info(filePath(songId));
+        if (in.status() != QDataStream::Ok || !info.exists())
+            continue;
+        entry.cachedBytes = qMin(entry.cachedBytes, info.size());
+        m_entries.insert(songId, entry);
+        m_totalBytes += entry.cachedBytes;
+    }
+    qDebug() << "StreamCache: Loaded" << m_entries.size() << "cached songs," << m_totalBytes << "bytes";
+}
+
+void StreamCache::saveIndex() const
+{
+    QSaveFile file(m_directory + "/index.dat");
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << IndexMagic << IndexVersion << qint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        out << qint32(it.key()) << it->cachedBytes << it->totalSize << it->lastUsed;
+    file.commit();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QUrl>
+#include <QPointer>
+#include <QNetworkReply>
+#include <QSharedPointer>
+#include <QWeakPointer>
+
+class CachedStream;
+class QFile;
+class StreamProgress;
+class QTimer;
+class SeekIndexBuilder;
+
+// Persistent, size-bounded LRU cache of song streams keyed by song id.
+// Songs are filled front to back with ranged GETs, so an interrupted fill
+// resumes from the bytes already on disk. Complete songs are played from
+// their local file, others through a CachedStream over the file being
+// filled; the least recently used songs are evicted first. The bytes of a
+// fill also build the song's seek index on the way through.
+class StreamCache : public QObject
+{
+    Q_OBJECT
+public:
+    static StreamCache *instance();
+
+    // Local file if the song is fully cached, otherwise the network url
+    QUrl playbackUrl(int songId, const QUrl &streamUrl);
+    // Reader over the cache file of a song that is not complete, so playback
+    // and the cache share one download: the bytes on disk are read at once
+    // and the rest as the fill started or joined here writes them. Owned by
+    // the caller; null if the song is complete
+    CachedStream *openStream(int songId, const QUrl &streamUrl);
+
+    // Throttled fills share the rate set by setThrottle() and stop reading while paused
+    void fill(int songId, const QUrl &streamUrl, bool throttled = false);
+    void setThrottle(qint64 bytesPerSecond);
+    void setThrottlePaused(bool paused);
+    bool isFilling(int songId) const { return m_fills.contains(songId); }
+    bool isThrottled(int songId) const { return m_fills.value(songId).throttled; }
+    void cancel(int songId);
+    bool isComplete(int songId) const;
+    // Path of the cached file, empty unless the song is complete
+    QString localFile(int songId) const;
+    QList<int> completeSongIds() const;
+    qint64 cachedBytes(int songId) const;
+    qint64 totalBytes() const { return m_totalBytes; }
+    qint64 maximumSize() const { return m_maximumSize; }
+
+signals:
+    void songCached(int songId);
+    void fillFinished(int songId);
+
+private slots:
+    void onFillReadyRead();
+    void onFillFinished();
+    void onThrottleTick();
+
+private:
+    struct Entry
+    {
+        qint64 cachedBytes = 0;
+        qint64 totalSize = -1; // -1 until the server reported it
+        qint64 lastUsed = 0;
+    };
+
+    struct Fill
+    {
+        QPointer<QNetworkReply> reply;
+        QFile *file = nullptr;
+        bool accepted = false;
+        bool throttled = false;
+        // Null once the song has an index
+        SeekIndexBuilder *seekIndex = nullptr;
+    };
+
+    StreamCache(QObject *parent = nullptr);
+    QString filePath(int songId) const;
+    void pull(int songId, QNetworkReply *reply, qint64 maxBytes);
+    bool acceptResponse(int songId, QNetworkReply *reply, Fill &fill);
+    void startSeekIndex(int songId, Fill &fill);
+    void indexCachedFile(int songId);
+    void touch(int songId);
+    void evict();
+    void remove(int songId);
+    void loadIndex();
+    void saveIndex() const;
+
+    static StreamCache *m_instance;
+    QString m_directory;
+    qint64 m_maximumSize;
+    qint64 m_totalBytes = 0;
+    QHash<int, Entry> m_entries;
+    QHash<int, Fill> m_fills;
+    // Shared with the open streams of each song
+    QHash<int, QWeakPointer<StreamProgress>> m_progress;
+    QTimer *m_throttleTimer;
+    qint64 m_throttleRate = 0;
+    bool m_throttlePaused = false;
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "StreamPrefetcher.hpp"
+#include "StreamCache.hpp"
+#include "HttpClient.hpp"
+#include "AppConfig.hpp"
+#include <QDebug>
+
+StreamPrefetcher::StreamPrefetcher(QObject *parent)
+    : QObject(parent), m_trackCount(AppConfig::instance().getPrefetchTrackCount())
+{
+    StreamCache *cache = StreamCache::instance();
+    cache->setThrottle(AppConfig::instance().getPrefetchMaxRate());
+    cache->setThrottlePaused(HttpClient::instance()->isForegroundBusy());
+    connect(cache, &StreamCache::fillFinished, this, &StreamPrefetcher::onFillFinished);
+    connect(HttpClient::instance(), &HttpClient::foregroundBusyChanged, cache, &StreamCache::setThrottlePaused);
+}
+
+void StreamPrefetcher::setUpcoming(const QList<int> &songIds)
+{
+    QList<int> upcoming = songIds.mid(0, m_trackCount);
+    if (upcoming == m_upcoming)
+        return;
+    m_upcoming = upcoming;
+    m_attempted.clear();
+
+    // Shuffle, repeat or a new queue made the running prefetch pointless; the bytes
+    // stay cached. A fill that playback has taken over is left running.
+    if (m_current != -1 && !m_upcoming.contains(m_current))
+    {
+        int stale = m_current;
+        m_current = -1;
+        if (StreamCache::instance()->isThrottled(stale))
+            StreamCache::instance()->cancel(stale);
+    }
+    startNext();
+}
+
+void StreamPrefetcher::onFillFinished(int songId)
+{
+    if (songId != m_current)
+        return;
+    m_current = -1;
+    startNext();
+}
+
+void StreamPrefetcher::startNext()
+{
+    if (m_current != -1)
+        return;
+
+    StreamCache *cache = StreamCache::instance();
+    for (int songId : m_upcoming)
+    {
+        // Songs already filling belong to playback, which fills at full speed
+        if (m_attempted.contains(songId) || cache->isComplete(songId) || cache->isFilling(songId))
+            continue;
+        m_attempted.insert(songId);
+        m_current = songId;
+        qDebug() << "StreamPrefetcher: Prefetching song" << songId;
+        cache->fill(songId, QUrl(AppConfig::instance().getSongsStreamEndpoint(songId)), true);
+        return;
+    }
+}
\ No newline at end of file
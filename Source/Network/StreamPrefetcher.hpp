@@ -0,0 +1,29 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QSet>
+
+// Downloads the next few songs of the play queue into the StreamCache in
+// the background, one at a time and under a bandwidth cap. Reading pauses
+// while a request the user is waiting on is in flight.
+class StreamPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamPrefetcher(QObject *parent = nullptr);
+
+    // Upcoming song ids in play order; only the first trackCount() are fetched
+    void setUpcoming(const QList<int> &songIds);
+    int trackCount() const { return m_trackCount; }
+
+private slots:
+    void onFillFinished(int songId);
+
+private:
+    void startNext();
+
+    QList<int> m_upcoming;
+    QSet<int> m_attempted;
+    int m_current = -1;
+    int m_trackCount;
+};
\ No newline at end of file
@@ -6,6 +6,7 @@ import QtMultimedia
 import "../Components"
 import "../Helper"
 import AppState 1.0
+import Spectrum 1.0
 
 Item {
     readonly property real scaleFactor: Math.min(parent.width / 1024, parent.height / 600)
@@ -41,16 +42,6 @@ Item {
 
     property bool isSearching: false
 
-    function formatDuration(milliseconds) {
-        if (!milliseconds || milliseconds < 0 || isNaN(milliseconds)) {
-            return "0:00";
-        }
-        let seconds = Math.floor(milliseconds / 1000);
-        let minutes = Math.floor(seconds / 60);
-        let secs = Math.floor(seconds % 60);
-        return minutes + ":" + (secs < 10 ? "0" : "") + secs;
-    }
-
     Rectangle {
         anchors.fill: parent
         gradient: Gradient {
@@ -174,12 +165,12 @@ Item {
                                     let songId = songViewModel.songModel.data(songViewModel.songModel.index(0, 0), songViewModel.songModel.IdRole);
                                     let title = songViewModel.songModel.data(songViewModel.songModel.index(0, 0), songViewModel.songModel.TitleRole);
                                     let artists = songViewModel.songModel.data(songViewModel.songModel.index(0, 0), songViewModel.songModel.ArtistsRole);
-                                    songViewModel.playSong(songId, title, artists);
                                     AppState.setState({
                                         title: title,
                                         artist: artists.join(", "),
                                         playlistId: -1
                                     });
+                                    songViewModel.playSong(songId, title, artists);
                                     searchResultsView.visible = false;
                                     searchInput.focus = false;
                                     isSearching = false;
@@ -361,12 +352,12 @@ Item {
                                 }
                                 onClicked: {
                                     if (songViewModel) {
-                                        songViewModel.playSong(model.id, model.title, model.artists);
                                         AppState.setState({
                                             title: model.title,
                                             artist: model.artists.join(", "),
                                             playlistId: -1
                                         });
+                                        songViewModel.playSong(model.id, model.title, model.artists);
                                         songViewModel.fetchAllSongs();
                                         searchResultsView.visible = false;
                                         searchInput.focus = false;
@@ -481,6 +472,16 @@ Item {
                 font.family: "Arial"
                 color: "#2d3748"
             }
+
+            SpectrumItem {
+                id: spectrumView
+                Layout.alignment: Qt.AlignHCenter
+                Layout.preferredWidth: parent.width * 0.6
+                Layout.preferredHeight: 60 * scaleFactor
+                analyzer: songViewModel ? songViewModel.spectrumAnalyzer : null
+                color: "#2b6cb0"
+                spacing: 2 * scaleFactor
+            }
         }
 
         ColumnLayout {
@@ -507,7 +508,7 @@ Item {
             Text {
                 id: timeText
                 Layout.alignment: Qt.AlignHCenter
-                text: (songViewModel ? formatDuration(songViewModel.position) : "0:00") + " / " + (songViewModel ? formatDuration(songViewModel.duration) : "0:00")
+                text: songViewModel ? songViewModel.timeText : "0:00 / 0:00"
                 font.pixelSize: songInfoTimeSize * scaleFactor
                 font.family: "Arial"
                 color: "#2d3748"
@@ -521,6 +522,7 @@ Item {
                 maxValue: songViewModel ? songViewModel.duration : 0
                 step: 1000
                 value: songViewModel ? songViewModel.position : 0
+                waveformSongId: songViewModel ? songViewModel.currentSongId : -1
                 backgroundColor: "#e2e8f0"
                 fillColor: "#2b6cb0"
                 handleColor: "#ffffff"
@@ -530,7 +532,6 @@ Item {
                     if (pressed && songViewModel) {
                         songViewModel.setPosition(value);
                     }
-                    console.log("Progress slider value:", value);
                 }
             }
 
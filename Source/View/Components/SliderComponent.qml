@@ -1,5 +1,6 @@
 import QtQuick 
 import QtQuick.Controls 
+import Waveform 1.0
 
 Slider {
     id: slider
@@ -17,6 +18,8 @@ Slider {
     property color borderColor: "#000000"
     property real handleSize: 14
     property real trackHeight: 4
+    // Song whose waveform replaces the plain track once it is available
+    property int waveformSongId: -1
 
     width: sliderWidth
     height: sliderHeight
@@ -25,21 +28,38 @@ Slider {
     value: initialValue
     stepSize: step
 
-    background: Rectangle {
+    background: Item {
         x: slider.leftPadding
-        y: slider.topPadding + slider.availableHeight / 2 - height / 2
+        y: slider.topPadding
         implicitWidth: sliderWidth
         implicitHeight: trackHeight
         width: slider.availableWidth
-        height: implicitHeight
-        radius: trackHeight / 2
-        color: backgroundColor
+        height: slider.availableHeight
+
+        WaveformItem {
+            id: waveform
+            anchors.fill: parent
+            songId: waveformSongId
+            progress: slider.visualPosition
+            color: backgroundColor
+            progressColor: fillColor
+            visible: available
+        }
 
         Rectangle {
-            width: slider.visualPosition * parent.width
-            height: parent.height
-            color: fillColor
+            y: parent.height / 2 - height / 2
+            width: parent.width
+            height: trackHeight
             radius: trackHeight / 2
+            color: backgroundColor
+            visible: !waveform.available
+
+            Rectangle {
+                width: slider.visualPosition * parent.width
+                height: parent.height
+                color: fillColor
+                radius: trackHeight / 2
+            }
         }
     }
 
@@ -2,7 +2,7 @@
 #include <QDebug>
 
 AdminViewModel::AdminViewModel(QObject *parent)
-    : QAbstractListModel(parent), m_adminModel(new AdminModel(this))
+    : KeyedListModel(parent), m_adminModel(new AdminModel(this))
 {
     connect(m_adminModel, &AdminModel::uploadFinished, this, [=](bool success, const QString &message, int songId)
             {
@@ -14,13 +14,14 @@ AdminViewModel::AdminViewModel(QObject *parent)
     connect(m_adminModel, &AdminModel::usersFetched, this, [=](bool success, const QVariantList &users, const QString &errorMessage)
             {
         if (success) {
-            beginResetModel();
-            m_users.clear();
+            QList<QVariantMap> newUsers;
+            newUsers.reserve(users.size());
             for (const QVariant &user : users) {
-                m_users.append(user.toMap());
+                newUsers.append(user.toMap());
             }
+            applyRows(m_users, newUsers, [](const QVariantMap &user) { return user["id"].toInt(); },
+                      [](const QVariantMap &a, const QVariantMap &b) { return a != b; });
             qDebug() << "AdminViewModel: Updated users, count:" << m_users.count() << ", first email:" << (m_users.isEmpty() ? "N/A" : m_users.value(0)["email"].toString());
-            endResetModel();
         }
         emit usersFetched(success, users, errorMessage); });
 }
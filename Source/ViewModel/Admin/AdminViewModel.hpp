@@ -1,8 +1,8 @@
 #pragma once
-#include <QAbstractListModel>
+#include "KeyedListModel.hpp"
 #include "AdminModel.hpp"
 
-class AdminViewModel : public QAbstractListModel
+class AdminViewModel : public KeyedListModel
 {
     Q_OBJECT
 
@@ -0,0 +1,118 @@
+#include "PlaybackClock.hpp"
+#include "AppConfig.hpp"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimer>
+
+namespace
+{
+    // Reports within this of the running position are drift, not a seek
+    constexpr qint64 MaxDriftMs = 250;
+    constexpr qreal DefaultRefreshRate = 60.0;
+
+    QString formatTime(qint64 milliseconds)
+    {
+        qint64 seconds = qMax<qint64>(milliseconds, 0) / 1000;
+        return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+}
+
+PlaybackClock::PlaybackClock(QObject *parent)
+    : QObject(parent), m_timer(new QTimer(this)), m_notifyIntervalMs(AppConfig::instance().getPositionNotifyMs())
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &PlaybackClock::tick);
+    updateTimer();
+    updateTimeText();
+}
+
+void PlaybackClock::setNotifyIntervalMs(int ms)
+{
+    if (ms < 0 || m_notifyIntervalMs == ms)
+        return;
+    m_notifyIntervalMs = ms;
+    updateTimer();
+}
+
+void PlaybackClock::sync(qint64 position)
+{
+    qint64 expected = predicted();
+    m_syncedPosition = position;
+    m_sinceSync.start();
+    // While running, the next tick carries small corrections along
+    if (!m_running || qAbs(position - expected) > MaxDriftMs)
+        publish(position);
+}
+
+void PlaybackClock::setDuration(qint64 duration)
+{
+    if (m_duration == duration)
+        return;
+    m_duration = duration;
+    updateTimeText();
+}
+
+void PlaybackClock::setRunning(bool running)
+{
+    if (m_running == running)
+        return;
+    // Stops where it is shown, without running past the last report
+    if (m_running)
+        m_syncedPosition = m_position;
+    m_sinceSync.start();
+    m_running = running;
+    updateTimer();
+}
+
+void PlaybackClock::tick()
+{
+    qint64 position = predicted();
+    // Behind a report that came in early; wait for it to catch up
+    if (position < m_position && m_position - position <= MaxDriftMs)
+        return;
+    publish(position);
+}
+
+qint64 PlaybackClock::predicted() const
+{
+    qint64 position = m_syncedPosition;
+    if (m_running && m_sinceSync.isValid())
+        position += m_sinceSync.elapsed();
+    return m_duration > 0 ? qMin(position, m_duration) : position;
+}
+
+void PlaybackClock::publish(qint64 position)
+{
+    if (m_position == position)
+        return;
+    bool secondChanged = m_position / 1000 != position / 1000;
+    m_position = position;
+    emit positionChanged();
+    if (secondChanged)
+        updateTimeText();
+}
+
+void PlaybackClock::updateTimeText()
+{
+    QString text = formatTime(m_position) + " / " + formatTime(m_duration);
+    if (text == m_timeText)
+        return;
+    m_timeText = text;
+    emit timeTextChanged();
+}
+
+void PlaybackClock::updateTimer()
+{
+    int interval = m_notifyIntervalMs;
+    if (interval == 0)
+    {
+        QScreen *screen = QGuiApplication::primaryScreen();
+        qreal refreshRate = screen ? qMax<qreal>(screen->refreshRate(), 1.0) : DefaultRefreshRate;
+        interval = qMax(1, qRound(1000.0 / refreshRate));
+    }
+    m_timer->setInterval(interval);
+    if (m_running)
+        m_timer->start();
+    else
+        m_timer->stop();
+}
\ No newline at end of file
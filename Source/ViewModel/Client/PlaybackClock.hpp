@@ -0,0 +1,50 @@
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+
+class QTimer;
+
+// Position for the view, decoupled from how often the backend reports it.
+// Between reports the position runs on from the last one, published at the
+// display refresh rate or a slower configured rate; small corrections are
+// absorbed so the slider never steps back. The time label is formatted
+// here and only changes when the shown second does.
+class PlaybackClock : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PlaybackClock(QObject *parent = nullptr);
+
+    qint64 position() const { return m_position; }
+    // "m:ss / m:ss"
+    QString timeText() const { return m_timeText; }
+    // 0 follows the display refresh rate
+    int notifyIntervalMs() const { return m_notifyIntervalMs; }
+    void setNotifyIntervalMs(int ms);
+
+    // A position reported by the backend
+    void sync(qint64 position);
+    void setDuration(qint64 duration);
+    void setRunning(bool running);
+
+signals:
+    void positionChanged();
+    void timeTextChanged();
+
+private:
+    void tick();
+    qint64 predicted() const;
+    void publish(qint64 position);
+    void updateTimeText();
+    void updateTimer();
+
+    QTimer *m_timer;
+    QElapsedTimer m_sinceSync;
+    qint64 m_syncedPosition = 0;
+    qint64 m_position = 0;
+    qint64 m_duration = 0;
+    bool m_running = false;
+    int m_notifyIntervalMs;
+    QString m_timeText;
+};
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "PlaybackMetrics.hpp"
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaEnum>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cmath>
+
+namespace
+{
+    // Upper edges in ms; the last bucket takes everything above 30 s
+    const qint64 BucketEdges[] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, -1};
+}
+
+void PlaybackMetrics::Histogram::add(qint64 ms)
+{
+    int bucket = 0;
+    while (BucketEdges[bucket] >= 0 && ms > BucketEdges[bucket])
+        ++bucket;
+    ++buckets[bucket];
+    min = count == 0 ? ms : qMin(min, ms);
+    max = count == 0 ? ms : qMax(max, ms);
+    sum += ms;
+    ++count;
+}
+
+qint64 PlaybackMetrics::Histogram::percentile(double fraction) const
+{
+    // Bucket resolution: the upper edge of the bucket holding the rank,
+    // clamped to what was actually seen
+    int rank = qMax(int(std::ceil(count * fraction)), 1);
+    int seen = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+            return BucketEdges[bucket] < 0 ? max : qBound(min, BucketEdges[bucket], max);
+    }
+    return max;
+}
+
+PlaybackMetrics::PlaybackMetrics(QObject *parent)
+    : QObject(parent)
+{
+    static_assert(sizeof(BucketEdges) / sizeof(BucketEdges[0]) == BucketCount, "one edge per bucket");
+}
+
+void PlaybackMetrics::start(int songId)
+{
+    m_songId = songId;
+    m_marked.fill(false);
+    m_runTimer.start();
+}
+
+void PlaybackMetrics::mark(Stage stage)
+{
+    if (!m_runTimer.isValid() || m_marked[stage])
+        return;
+    m_marked[stage] = true;
+    qint64 elapsed = m_runTimer.elapsed();
+    m_histograms[stage].add(elapsed);
+
+    if (stage != Audible)
+        return;
+    // The run is complete once sound comes out
+    m_runTimer.invalidate();
+    ++m_runCount;
+    m_lastTimeToAudioMs = elapsed;
+    emit updated();
+    qDebug() << "PlaybackMetrics: Song" << m_songId << "audible after" << elapsed << "ms";
+}
+
+void PlaybackMetrics::mark(Stage stage, int songId)
+{
+    if (songId == m_songId)
+        mark(stage);
+}
+
+QVariantList PlaybackMetrics::histograms() const
+{
+    const QMetaEnum stages = QMetaEnum::fromType<Stage>();
+    QVariantList result;
+    for (int stage = 0; stage < StageCount; ++stage)
+    {
+        const Histogram &histogram = m_histograms[stage];
+        QVariantList buckets;
+        for (int bucket = 0; bucket < BucketCount; ++bucket)
+            buckets.append(QVariantMap{{"upToMs", BucketEdges[bucket]}, {"count", histogram.buckets[bucket]}});
+
+        QVariantMap entry;
+        entry["stage"] = QString::fromLatin1(stages.valueToKey(stage));
+        entry["count"] = histogram.count;
+        entry["minMs"] = histogram.min;
+        entry["maxMs"] = histogram.max;
+        entry["meanMs"] = histogram.count > 0 ? histogram.sum / histogram.count : 0;
+        entry["p50Ms"] = histogram.count > 0 ? histogram.percentile(0.5) : 0;
+        entry["p90Ms"] = histogram.count > 0 ? histogram.percentile(0.9) : 0;
+        entry["p99Ms"] = histogram.count > 0 ? histogram.percentile(0.99) : 0;
+        entry["buckets"] = buckets;
+        result.append(entry);
+    }
+    return result;
+}
+
+bool PlaybackMetrics::dump(const QString &path) const
+{
+    QString filePath = path.isEmpty() ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/playback-metrics.json" : path;
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "PlaybackMetrics: Cannot write" << filePath << file.errorString();
+        return false;
+    }
+
+    QJsonObject root;
+    root["runs"] = m_runCount;
+    root["stages"] = QJsonArray::fromVariantList(histograms());
+    file.write(QJsonDocument(root).toJson());
+    if (!file.commit())
+        return false;
+    qDebug() << "PlaybackMetrics: Dumped" << m_runCount << "runs to" << filePath;
+    return true;
+}
+
+void PlaybackMetrics::reset()
+{
+    m_histograms.fill(Histogram());
+    m_marked.fill(false);
+    m_runTimer.invalidate();
+    m_runCount = 0;
+    m_lastTimeToAudioMs = -1;
+    emit updated();
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVariantList>
+#include <array>
+
+// Time to first audio, split into checkpoints along the play pipeline.
+// Every checkpoint is timed from the playSong() call that started the run
+// and only its first occurrence per run counts. Each stage aggregates into
+// a fixed-bucket histogram, so a long session costs no more memory than a
+// short one. Stages that a path never reaches (no stream when the song is
+// cached, no media status on the audio engine) simply get fewer samples.
+class PlaybackMetrics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int runCount READ runCount NOTIFY updated)
+    Q_PROPERTY(qint64 lastTimeToAudioMs READ lastTimeToAudioMs NOTIFY updated)
+public:
+    enum Stage
+    {
+        SourceSet,    // Player or engine was handed the url
+        FirstBytes,   // Player or engine read the first bytes of the song's cache stream
+        Loaded,       // LoadedMedia
+        Buffered,     // BufferedMedia
+        Playing,      // PlayingState
+        Audible,      // First position report past zero
+        StageCount
+    };
+    Q_ENUM(Stage)
+
+    explicit PlaybackMetrics(QObject *parent = nullptr);
+
+    int runCount() const { return m_runCount; }
+    qint64 lastTimeToAudioMs() const { return m_lastTimeToAudioMs; }
+
+    // Starts a run; one still waiting for audio is abandoned
+    void start(int songId);
+    void mark(Stage stage);
+    // For checkpoints that arrive for any song, such as stream reads
+    void mark(Stage stage, int songId);
+
+    // One map per stage: stage, count, minMs, maxMs, meanMs, p50Ms, p90Ms,
+    // p99Ms and buckets, a list of {upToMs, count} where the last upToMs
+    // is -1 for everything slower
+    Q_INVOKABLE QVariantList histograms() const;
+    // JSON; an empty path writes playback-metrics.json in the app data folder
+    Q_INVOKABLE bool dump(const QString &path = QString()) const;
+    Q_INVOKABLE void reset();
+
+signals:
+    void updated();
+
+private:
+    static constexpr int BucketCount = 12;
+
+    struct Histogram
+    {
+        std::array<int, BucketCount> buckets = {};
+        int count = 0;
+        qint64 sum = 0;
+        qint64 min = 0;
+        qint64 max = 0;
+
+        void add(qint64 ms);
+        qint64 percentile(double fraction) const;
+    };
+
+    QElapsedTimer m_runTimer;
+    int m_songId = -1;
+    std::array<bool, StageCount> m_marked = {};
+    std::array<Histogram, StageCount> m_histograms;
+    int m_runCount = 0;
+    qint64 m_lastTimeToAudioMs = -1;
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "PlaylistViewModel.hpp"
 #include "AppState.hpp"
+#include "SongCatalog.hpp"
 #include <QDebug>
 
 PlaylistViewModel::PlaylistViewModel(QObject *parent)
@@ -206,19 +207,13 @@ void PlaylistViewModel::onSongRemoved(int playlistId, int songId)
     qDebug() << "PlaylistViewModel: Song removed from playlist, ID:" << playlistId << "Song ID:" << songId;
 }
 
-void PlaylistViewModel::onSongsLoaded(int playlistId, const QList<SongData> &songs, const QString &message)
+void PlaylistViewModel::onSongsLoaded(int playlistId, const QList<int> &songIds, const QString &message)
 {
+    const SongCatalog &catalog = SongCatalog::instance();
     QVariantList songList;
-    for (const SongData &song : songs)
-    {
-        QVariantMap songMap;
-        songMap["id"] = song.id;
-        songMap["title"] = song.title;
-        songMap["artists"] = song.artists;
-        songMap["file_path"] = song.filePath;
-        songMap["genres"] = song.genres;
-        songList.append(songMap);
-    }
+    songList.reserve(songIds.count());
+    for (int songId : songIds)
+        songList.append(catalog.toVariantMap(songId));
     emit songsLoaded(playlistId, songList, message);
     qDebug() << "PlaylistViewModel: Songs loaded for playlist" << playlistId << ", count:" << songList.count();
 }
@@ -239,19 +234,13 @@ void PlaylistViewModel::onSearchResultsLoaded(const QList<PlaylistData> &playlis
     qDebug() << "PlaylistViewModel: Playlist search results loaded, count:" << playlistList.count();
 }
 
-void PlaylistViewModel::onSongSearchResultsLoaded(int playlistId, const QList<SongData> &songs, const QString &message)
+void PlaylistViewModel::onSongSearchResultsLoaded(int playlistId, const QList<int> &songIds, const QString &message)
 {
+    const SongCatalog &catalog = SongCatalog::instance();
     QVariantList songList;
-    for (const SongData &song : songs)
-    {
-        QVariantMap songMap;
-        songMap["id"] = song.id;
-        songMap["title"] = song.title;
-        songMap["artists"] = song.artists;
-        songMap["file_path"] = song.filePath;
-        songMap["genres"] = song.genres;
-        songList.append(songMap);
-    }
+    songList.reserve(songIds.count());
+    for (int songId : songIds)
+        songList.append(catalog.toVariantMap(songId));
     emit songSearchResultsLoaded(playlistId, songList, message);
     qDebug() << "PlaylistViewModel: Song search results loaded for playlist" << playlistId << ", count:" << songList.count();
 }
\ No newline at end of file
@@ -63,9 +63,9 @@ private slots:
     void onPlaylistDeleted(int playlistId);
     void onSongAdded(int playlistId);
     void onSongRemoved(int playlistId, int songId);
-    void onSongsLoaded(int playlistId, const QList<SongData> &songs, const QString &message);
+    void onSongsLoaded(int playlistId, const QList<int> &songIds, const QString &message);
     void onSearchResultsLoaded(const QList<PlaylistData> &playlists, const QString &message);
-    void onSongSearchResultsLoaded(int playlistId, const QList<SongData> &songs, const QString &message);
+    void onSongSearchResultsLoaded(int playlistId, const QList<int> &songIds, const QString &message);
 
 private:
     PlaylistModel *m_playlistModel;
@@ -1,33 +1,168 @@
 #include "SongViewModel.hpp"
 #include "AppState.hpp"
+#include "SongCatalog.hpp"
+#include "AppConfig.hpp"
+#include "StreamCache.hpp"
+#include "AudioEngine.hpp"
+#include "CachedStream.hpp"
+#include "LoudnessAnalyzer.hpp"
+#include "LoudnessStore.hpp"
+#include "SeekIndexStore.hpp"
+#include <QCoreApplication>
 #include <QDebug>
-#include <QRandomGenerator>
+#include <QJsonObject>
+#include <cmath>
+
+namespace
+{
+    const int MaxSessionSongs = 500;
+    // A seek this far past the cache fill is fetched on its own
+    const qint64 FarSeekBytes = 512 * 1024;
+}
 
 SongViewModel::SongViewModel(QObject *parent)
-    : QObject(parent), m_songModel(new SongModel(this)), m_mediaPlayer(new QMediaPlayer(this)), m_audioOutput(new QAudioOutput(this))
+    : QObject(parent), m_songModel(new SongModel(this)), m_library(new SongModel(this)), m_clock(new PlaybackClock(this)), m_mediaPlayer(new QMediaPlayer(this)), m_audioOutput(new QAudioOutput(this)),
+      m_nextPlayer(new QMediaPlayer(this)), m_nextAudioOutput(new QAudioOutput(this)),
+      m_gaplessLeadTimeMs(AppConfig::instance().getGaplessLeadTimeMs()), m_crossfadeMs(AppConfig::instance().getCrossfadeMs()),
+      m_prefetcher(new StreamPrefetcher(this)), m_playQueue(new PlayQueue(this)),
+      m_loudnessAnalyzer(new LoudnessAnalyzer(this)),
+      m_loudnessNormalization(AppConfig::instance().isLoudnessNormalizationEnabled()),
+      m_spectrumAnalyzer(new SpectrumAnalyzer(this)),
+      m_seekIndexEnabled(AppConfig::instance().isSeekIndexEnabled()),
+      m_session(new PlaybackSession(this)),
+      m_metrics(new PlaybackMetrics(this))
 {
     m_mediaPlayer->setAudioOutput(m_audioOutput);
-    m_audioOutput->setVolume(0.5);
-
-    connect(m_mediaPlayer, &QMediaPlayer::mediaStatusChanged,
-            this, &SongViewModel::onMediaStatusChanged);
-    connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged,
-            this, &SongViewModel::onPlaybackStateChanged);
-    connect(m_mediaPlayer, &QMediaPlayer::positionChanged,
-            this, &SongViewModel::onPositionChanged);
-    connect(m_mediaPlayer, &QMediaPlayer::durationChanged,
-            this, &SongViewModel::onDurationChanged);
-    connect(m_mediaPlayer, &QMediaPlayer::errorOccurred,
-            this, &SongViewModel::onErrorOccurred);
+    m_nextPlayer->setAudioOutput(m_nextAudioOutput);
+    m_mediaPlayer->setAudioBufferOutput(m_spectrumAnalyzer->tap());
+    applyVolume();
+    setShuffleSeed(AppConfig::instance().getShuffleSeed());
+
+    connectPlayer(m_mediaPlayer);
+    connectPlayer(m_nextPlayer);
+    connect(m_clock, &PlaybackClock::positionChanged, this, &SongViewModel::positionChanged);
+    connect(m_clock, &PlaybackClock::timeTextChanged, this, &SongViewModel::timeTextChanged);
+    connect(this, &SongViewModel::isPlayingChanged, this, [this]()
+            { m_clock->setRunning(isPlaying()); });
+    connect(this, &SongViewModel::durationChanged, this, [this]()
+            { m_clock->setDuration(duration()); });
+    m_library->setPageSize(0);
     connect(m_songModel, &SongModel::songsChanged,
             this, &SongViewModel::onSongsFetched);
+    connect(m_library, &SongModel::songsChanged,
+            this, &SongViewModel::refreshQueue);
+    connect(AppState::instance(), &AppState::currentMediaFilesChanged,
+            this, &SongViewModel::refreshQueue);
+    // Queue edits from QML change what plays next
+    connect(m_playQueue, &PlayQueue::queueChanged, this, [this]()
+            {
+        disarmNextSong();
+        if (m_shuffle)
+            m_shuffleOrder.update(m_playQueue->songIds());
+        updatePrefetch(); });
+    if (AppConfig::instance().isAudioEngineEnabled())
+        setAudioEngineEnabled(true);
+
+    // Before any fetch returns, so the last song is ready on the first frame
+    restoreSession();
+    m_session->setProvider([this](bool withSongs)
+                           { return sessionSnapshot(withSongs); });
+    connect(m_playQueue, &PlayQueue::queueChanged, m_session, [this]()
+            { m_session->scheduleSave(true); });
+    connect(this, &SongViewModel::currentSongChanged, m_session, [this]()
+            { m_session->scheduleSave(); });
+    connect(this, &SongViewModel::shuffleChanged, m_session, [this]()
+            { m_session->scheduleSave(); });
+    connect(this, &SongViewModel::repeatModeChanged, m_session, [this]()
+            { m_session->scheduleSave(); });
+    connect(this, &SongViewModel::isPlayingChanged, m_session, [this]()
+            { m_session->scheduleSave(); });
+    connect(this, &SongViewModel::positionChanged, m_session, [this]()
+            { m_session->scheduleSave(); });
+
+    // Both backends report through isPlayingChanged
+    connect(this, &SongViewModel::isPlayingChanged, m_metrics, [this]()
+            {
+        if (isPlaying())
+            m_metrics->mark(PlaybackMetrics::Playing); });
+    QString metricsFile = AppConfig::instance().getPlaybackMetricsFile();
+    if (!metricsFile.isEmpty())
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, m_metrics, [this, metricsFile]()
+                { m_metrics->dump(metricsFile); });
+}
+
+bool SongViewModel::isPlaying() const
+{
+    if (m_audioEngine)
+        return m_audioEngine->isPlaying();
+    return m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
+}
+
+qint64 SongViewModel::backendPosition() const
+{
+    return m_audioEngine ? m_audioEngine->position() : m_mediaPlayer->position();
+}
+
+qint64 SongViewModel::duration() const
+{
+    return m_audioEngine ? m_audioEngine->duration() : m_mediaPlayer->duration();
+}
+
+void SongViewModel::setAudioEngineEnabled(bool enabled)
+{
+    if (enabled == (m_audioEngine != nullptr))
+        return;
+
+    disarmNextSong();
+    if (enabled)
+    {
+        m_mediaPlayer->stop();
+        m_spectrumAnalyzer->setActive(false);
+        m_audioEngine = new AudioEngine(this);
+        if (!m_audioEngine->isAvailable())
+        {
+            delete m_audioEngine;
+            m_audioEngine = nullptr;
+            emit errorOccurred("Audio engine is not supported by the output device");
+            return;
+        }
+        m_audioEngine->setVolume(m_volume);
+        connect(m_audioEngine, &AudioEngine::positionChanged, this, &SongViewModel::onPositionChanged);
+        connect(m_audioEngine, &AudioEngine::durationChanged, this, &SongViewModel::onDurationChanged);
+        connect(m_audioEngine, &AudioEngine::playingChanged, this, &SongViewModel::isPlayingChanged);
+        connect(m_audioEngine, &AudioEngine::nextTrackStarted, this, &SongViewModel::onEngineNextTrackStarted);
+        connect(m_audioEngine, &AudioEngine::finished, this, &SongViewModel::onEngineFinished);
+        connect(m_audioEngine, &AudioEngine::errorOccurred, this, &SongViewModel::errorOccurred);
+    }
+    else
+    {
+        delete m_audioEngine;
+        m_audioEngine = nullptr;
+    }
+
+    emit audioEngineEnabledChanged();
+    emit isPlayingChanged();
+    m_clock->sync(backendPosition());
+    emit durationChanged();
+    qDebug() << "SongViewModel: Audio engine enabled:" << enabled;
+}
+
+void SongViewModel::setCrossfadeMs(int ms)
+{
+    if (ms < 0 || m_crossfadeMs == ms)
+        return;
+    m_crossfadeMs = ms;
+    // Re-armed with the new length on the next position update
+    disarmNextSong();
+    emit crossfadeMsChanged();
 }
 
 void SongViewModel::setVolume(qreal volume)
 {
-    if (volume != m_audioOutput->volume())
+    if (volume != m_volume)
     {
-        m_audioOutput->setVolume(volume);
+        m_volume = volume;
+        applyVolume();
         m_muted = (volume == 0);
         if (!m_muted)
             m_previousVolume = volume;
@@ -44,19 +179,46 @@ void SongViewModel::setMuted(bool muted)
         m_muted = muted;
         if (muted)
         {
-            m_previousVolume = m_audioOutput->volume();
-            m_audioOutput->setVolume(0);
+            m_previousVolume = m_volume;
+            m_volume = 0;
         }
         else
         {
-            m_audioOutput->setVolume(m_previousVolume);
+            m_volume = m_previousVolume;
         }
+        applyVolume();
         emit mutedChanged();
         emit volumeChanged();
-        qDebug() << "SongViewModel: Muted set to" << muted << "volume:" << m_audioOutput->volume();
+        qDebug() << "SongViewModel: Muted set to" << muted << "volume:" << m_volume;
     }
 }
 
+void SongViewModel::setLoudnessNormalization(bool enabled)
+{
+    if (m_loudnessNormalization == enabled)
+        return;
+    m_loudnessNormalization = enabled;
+    // The engine picks the change up from the next song
+    applyVolume();
+    emit loudnessNormalizationChanged();
+}
+
+qreal SongViewModel::trackGain(int songId) const
+{
+    if (!m_loudnessNormalization || songId == -1)
+        return 1.0;
+    return std::pow(10.0, LoudnessStore::instance().gainDb(songId) / 20.0);
+}
+
+void SongViewModel::applyVolume()
+{
+    // QAudioOutput cannot go above full scale, so there normalization only turns songs down
+    m_audioOutput->setVolume(qMin(m_volume * trackGain(m_currentSongId), 1.0));
+    m_nextAudioOutput->setVolume(qMin(m_volume * trackGain(m_armedSongId), 1.0));
+    if (m_audioEngine)
+        m_audioEngine->setVolume(m_volume);
+}
+
 void SongViewModel::search(const QString &query)
 {
     m_songModel->setQuery(query);
@@ -65,35 +227,124 @@ void SongViewModel::search(const QString &query)
 void SongViewModel::fetchAllSongs()
 {
     m_songModel->fetchAllSongs();
+    m_library->fetchAllSongs();
 }
 
 void SongViewModel::playSong(int songId, const QString &title, const QStringList &artists)
 {
-    QString streamUrl = m_songModel->getStreamUrl(songId);
+    // Playing from another list makes that list the queue; within the same
+    // one the queue keeps its edits
+    AppState *state = AppState::instance();
+    if (state->currentPlaylistId() != m_queuePlaylistId || m_playQueue->count() == 0)
+    {
+        m_queuePlaylistId = state->currentPlaylistId();
+        m_queuePlaylistName = m_queuePlaylistId == -1 ? QString() : state->currentPlaylistName();
+        m_playQueue->setSongs(queueSource(m_queuePlaylistId));
+    }
+    startSong(songId, title, artists);
+}
+
+void SongViewModel::startSong(int songId, const QString &title, const QStringList &artists)
+{
+    // Before the song's stream is opened, which may already start the fill
+    m_metrics->start(songId);
+    QUrl streamUrl = StreamCache::instance()->playbackUrl(songId, QUrl(m_songModel->getStreamUrl(songId)));
+    m_currentSongId = songId;
+    if (!m_playQueue->setCurrentSongId(songId))
+        m_playQueue->setCurrentIndex(-1);
+    if (m_shuffle)
+        m_shuffleOrder.setCurrent(songId);
     m_currentSongTitle = title;
     m_currentSongArtists = artists;
+    m_restorePosition = -1;
+    m_restoreUrl.clear();
 
-    m_mediaPlayer->setSource(QUrl(streamUrl));
-    m_mediaPlayer->play();
+    bool switched = switchToArmedPlayer(songId);
+    applyVolume();
+    if (!switched)
+    {
+        disarmNextSong();
+        if (m_audioEngine)
+        {
+            m_audioEngine->play(streamUrl, trackGain(songId), openStream(songId, streamUrl));
+        }
+        else
+        {
+            setPlayerSource(m_mediaPlayer, songId, streamUrl);
+            m_mediaPlayer->play();
+        }
+        m_metrics->mark(PlaybackMetrics::SourceSet);
+    }
 
+    updatePrefetch();
     emit currentSongChanged();
-    qDebug() << "SongViewModel: Playing song:" << title << "by" << artists.join(", ") << "URL:" << streamUrl;
+    qDebug() << "SongViewModel: Playing song:" << title << "by" << artists.join(", ") << "URL:" << streamUrl.toString();
 }
 
 void SongViewModel::setPosition(qint64 position)
 {
-    m_mediaPlayer->setPosition(position);
+    SeekIndex::Point point;
+    if (m_seekIndexEnabled && m_currentSongId >= 0)
+        point = SeekIndexStore::instance().index(m_currentSongId).pointAt(position);
+    // Only the engine decodes from the indexed frame; the player just uses
+    // the point to judge how far the seek lands
+    m_seekIndexed = m_audioEngine && point.byteOffset > 0;
+
+    if (isPlaying())
+    {
+        m_seekTimer.start();
+        m_seekTarget = position;
+    }
+    else
+    {
+        m_seekTimer.invalidate();
+    }
+
+    if (m_audioEngine)
+    {
+        m_audioEngine->setPosition(position, point.byteOffset, point.timeMs);
+    }
+    else if (!reopenAt(position, point))
+    {
+        m_mediaPlayer->setPosition(position);
+    }
+    // Shows the target right away rather than waiting for the backend
+    m_clock->sync(position);
+}
+
+void SongViewModel::setPositionNotifyMs(int ms)
+{
+    if (ms < 0 || ms == m_clock->notifyIntervalMs())
+        return;
+    m_clock->setNotifyIntervalMs(ms);
+    emit positionNotifyMsChanged();
 }
 
 void SongViewModel::play()
 {
-    m_mediaPlayer->play();
+    if (m_audioEngine && !m_restoreUrl.isEmpty())
+    {
+        // The fill started by restoreSession() may have completed since
+        QUrl streamUrl = StreamCache::instance()->playbackUrl(m_currentSongId, QUrl(m_songModel->getStreamUrl(m_currentSongId)));
+        m_audioEngine->play(streamUrl, trackGain(m_currentSongId), openStream(m_currentSongId, streamUrl));
+        m_restoreUrl.clear();
+        if (m_restorePosition > 0)
+            setPosition(m_restorePosition);
+        m_restorePosition = -1;
+    }
+    else if (m_audioEngine)
+        m_audioEngine->resume();
+    else
+        m_mediaPlayer->play();
     emit isPlayingChanged();
 }
 
 void SongViewModel::pause()
 {
-    m_mediaPlayer->pause();
+    if (m_audioEngine)
+        m_audioEngine->pause();
+    else
+        m_mediaPlayer->pause();
     emit isPlayingChanged();
 }
 
@@ -102,6 +353,12 @@ void SongViewModel::setShuffle(bool shuffle)
     if (m_shuffle != shuffle)
     {
         m_shuffle = shuffle;
+        if (shuffle)
+            m_shuffleOrder.reset(m_playQueue->songIds(), m_currentSongId);
+        else
+            m_shuffleOrder.clear();
+        disarmNextSong();
+        updatePrefetch();
         emit shuffleChanged();
         qDebug() << "SongViewModel: Shuffle set to" << shuffle;
     }
@@ -112,172 +369,523 @@ void SongViewModel::setRepeatMode(int mode)
     if (m_repeatMode != mode)
     {
         m_repeatMode = mode;
+        disarmNextSong();
+        updatePrefetch();
         emit repeatModeChanged();
         qDebug() << "SongViewModel: Repeat mode set to" << mode;
     }
 }
 
-QString SongViewModel::normalizeString(const QString &str) const
+QList<int> SongViewModel::queueSource(int playlistId) const
+{
+    if (playlistId == -1)
+        return m_library->songIds();
+
+    // Playlist songs reach AppState as QVariantMaps from QML; put them in the catalog by id
+    const QVariantList mediaFiles = AppState::instance()->currentMediaFiles();
+    QList<SongData> songs;
+    songs.reserve(mediaFiles.size());
+    for (const QVariant &song : mediaFiles)
+        songs.append(SongModel::parseSong(QJsonObject::fromVariantMap(song.toMap())));
+    return SongCatalog::instance().insert(songs);
+}
+
+void SongViewModel::refreshQueue()
 {
-    return str.trimmed().replace(QRegularExpression("\\s+"), " ");
+    if (sender() == m_library && m_queuePlaylistId != -1)
+        return;
+    // AppState holds the songs of the playlist being browsed, which need not be the queue's
+    if (sender() != m_library && AppState::instance()->currentPlaylistId() != m_queuePlaylistId)
+        return;
+    m_playQueue->mergeSongs(queueSource(m_queuePlaylistId));
+    // A song played before its list arrived is found in it now
+    if (m_playQueue->currentIndex() == -1 && m_currentSongId != -1)
+        m_playQueue->setCurrentSongId(m_currentSongId);
 }
 
-int SongViewModel::findCurrentSongIndex(const QVariantList &songList) const
+void SongViewModel::restoreSession()
 {
-    if (songList.isEmpty() || m_currentSongTitle.isEmpty())
+    AppState *state = AppState::instance();
+    PlaybackSnapshot snapshot;
+    // Another account's queue stays where it is
+    if (!state->isAuthenticated() || !m_session->load(&snapshot) || snapshot.userId != state->userId() ||
+        snapshot.currentSongId < 0)
+        return;
+
+    m_queuePlaylistId = snapshot.playlistId;
+    m_queuePlaylistName = snapshot.playlistName;
+    if (snapshot.playlistId == -1)
+    {
+        // The full library is merged into this once it is fetched
+        QList<SongData> songs;
+        songs.reserve(snapshot.songs.size());
+        for (const QVariantMap &song : snapshot.songs)
+            songs.append(SongModel::parseSong(QJsonObject::fromVariantMap(song)));
+        m_playQueue->setSongs(SongCatalog::instance().insert(songs));
+    }
+    else
+    {
+        QVariantList mediaFiles;
+        mediaFiles.reserve(snapshot.songs.size());
+        for (const QVariantMap &song : snapshot.songs)
+            mediaFiles.append(song);
+        state->setState({{"playlistName", snapshot.playlistName}, {"mediaFiles", mediaFiles}, {"playlistId", snapshot.playlistId}});
+        m_playQueue->setSongs(queueSource(snapshot.playlistId));
+    }
+    // The queue was written apart from the rest and may predate it
+    if (!m_playQueue->setCurrentSongId(snapshot.currentSongId))
     {
-        qDebug() << "SongViewModel: Song list empty or no current song";
-        return 0;
+        qDebug() << "SongViewModel: Restored queue does not hold song" << snapshot.currentSongId;
+        return;
     }
 
-    QString normalizedTitle = normalizeString(m_currentSongTitle);
-    QString normalizedArtist = normalizeString(m_currentSongArtists.join(", "));
-    for (int i = 0; i < songList.size(); ++i)
+    const SongCatalog &catalog = SongCatalog::instance();
+    m_currentSongId = snapshot.currentSongId;
+    m_currentSongTitle = catalog.title(m_currentSongId);
+    m_currentSongArtists = catalog.artists(m_currentSongId);
+    state->setState({{"title", m_currentSongTitle}, {"artist", currentSongArtist()}});
+    setShuffle(snapshot.shuffle);
+    setRepeatMode(qBound(0, snapshot.repeatMode, 2));
+
+    // Opened but not started: the stream starts filling now and play()
+    // only has to resume
+    QUrl streamUrl = StreamCache::instance()->playbackUrl(m_currentSongId, QUrl(m_songModel->getStreamUrl(m_currentSongId)));
+    m_restorePosition = snapshot.positionMs;
+    if (m_audioEngine)
     {
-        QVariantMap song = songList[i].toMap();
-        QString songTitle = normalizeString(song.value("title").toString());
-        QString songArtists = normalizeString(song.value("artists").toStringList().join(", "));
-        if (songTitle == normalizedTitle && songArtists == normalizedArtist)
-        {
-            return i;
-        }
+        m_restoreUrl = streamUrl;
+        if (!StreamCache::instance()->isComplete(m_currentSongId))
+            StreamCache::instance()->fill(m_currentSongId, streamUrl);
     }
-    qDebug() << "SongViewModel: Current song not found in list, defaulting to index 0";
-    return 0;
+    else
+    {
+        setPlayerSource(m_mediaPlayer, m_currentSongId, streamUrl);
+    }
+    applyVolume();
+    m_clock->sync(snapshot.positionMs);
+    updatePrefetch();
+    emit currentSongChanged();
+    qDebug() << "SongViewModel: Restored session at song" << m_currentSongTitle << "position" << snapshot.positionMs;
 }
 
-void SongViewModel::playSongAtIndex(const QVariantList &songList, int index)
+PlaybackSnapshot SongViewModel::sessionSnapshot(bool withSongs) const
 {
-    if (index < 0 || index >= songList.size())
+    AppState *state = AppState::instance();
+    PlaybackSnapshot snapshot;
+    snapshot.userId = state->userId();
+    snapshot.playlistId = m_queuePlaylistId;
+    snapshot.playlistName = m_queuePlaylistName;
+    snapshot.currentSongId = m_currentSongId;
+    snapshot.positionMs = position();
+    snapshot.shuffle = m_shuffle;
+    snapshot.repeatMode = m_repeatMode;
+    if (!withSongs)
+        return snapshot;
+
+    // The whole library can be the queue; a window around the current song
+    // keeps the file small and the library fetch restores the rest
+    const QList<int> songIds = m_playQueue->songIds();
+    const SongCatalog &catalog = SongCatalog::instance();
+    qsizetype first = qMax<qsizetype>(m_playQueue->currentIndex() - MaxSessionSongs / 2, 0);
+    qsizetype last = qMin<qsizetype>(first + MaxSessionSongs, songIds.size());
+    first = qMax<qsizetype>(last - MaxSessionSongs, 0);
+    snapshot.songs.reserve(last - first);
+    for (qsizetype i = first; i < last; ++i)
+        snapshot.songs.append(catalog.toVariantMap(songIds.at(i)));
+    return snapshot;
+}
+
+void SongViewModel::playSongAtIndex(int index)
+{
+    int songId = m_playQueue->songIdAt(index);
+    if (songId == -1)
     {
         qDebug() << "SongViewModel: Invalid song index:" << index;
         return;
     }
-    QVariantMap song = songList[index].toMap();
-    int songId = song.value("id").toInt();
-    QString title = song.value("title").toString();
-    QStringList artists = song.value("artists").toStringList();
-    QString filePath = song.value("file_path").toString();
+    const SongCatalog &catalog = SongCatalog::instance();
+    QString title = catalog.title(songId);
+    QStringList artists = catalog.artists(songId);
+    QString filePath = catalog.filePath(songId);
 
     AppState::instance()->setState({{"title", title},
                                     {"artist", artists.join(", ")},
                                     {"filePath", filePath},
                                     {"playlistId", AppState::instance()->currentPlaylistId()}});
 
-    playSong(songId, title, artists);
+    m_playQueue->setCurrentIndex(index);
+    startSong(songId, title, artists);
     qDebug() << "SongViewModel: Playing song at index:" << index << "Title:" << title << "Artists:" << artists.join(", ");
 }
 
 void SongViewModel::nextSong()
 {
-    QVariantList songList = AppState::instance()->currentPlaylistId() != -1
-                                ? AppState::instance()->currentMediaFiles()
-                                : m_allSongs;
-
-    if (songList.isEmpty())
+    if (m_playQueue->count() == 0)
     {
         qDebug() << "SongViewModel: No songs available to play";
         return;
     }
 
-    int currentIndex = findCurrentSongIndex(songList);
-    if (m_repeatMode == 1)
+    // Deterministic, so it matches the armed song, including a shuffled pick
+    int nextIndex = followingIndex();
+    if (nextIndex < 0)
     {
-        playSongAtIndex(songList, currentIndex);
+        qDebug() << "SongViewModel: Reached end of song list, stopping";
+        return;
     }
-    else
+    playSongAtIndex(nextIndex);
+}
+
+int SongViewModel::followingIndex()
+{
+    if (m_playQueue->count() == 0)
+        return -1;
+    if (m_repeatMode == 1)
+        return qMax(m_playQueue->currentIndex(), 0);
+    if (m_shuffle)
     {
-        int nextIndex;
-        if (m_shuffle)
+        int songId = m_shuffleOrder.next();
+        if (songId == -1)
         {
-            nextIndex = QRandomGenerator::global()->bounded(songList.size());
-            while (nextIndex == currentIndex && songList.size() > 1)
-            {
-                nextIndex = QRandomGenerator::global()->bounded(songList.size());
-            }
+            if (m_repeatMode != 2)
+                return -1;
+            // The new round starts when its first song does, so previous
+            // still works while the last song of this one plays
+            songId = m_shuffleOrder.peekNextRound(m_currentSongId);
         }
-        else
+        return m_playQueue->songIds().indexOf(songId);
+    }
+    return m_playQueue->nextIndex(m_repeatMode == 2);
+}
+
+QList<int> SongViewModel::upcomingSongIds(int count)
+{
+    QList<int> upcoming;
+    int queueSize = m_playQueue->count();
+    if (queueSize == 0 || count <= 0)
+        return upcoming;
+
+    int index = m_playQueue->currentIndex();
+    if (m_repeatMode == 1)
+    {
+        upcoming.append(m_playQueue->songIdAt(qMax(index, 0)));
+    }
+    else if (m_shuffle)
+    {
+        upcoming = m_shuffleOrder.upcoming(count);
+    }
+    else
+    {
+        for (int i = 0; i < count && i < queueSize; ++i)
         {
-            nextIndex = currentIndex + 1;
-            if (nextIndex >= songList.size())
+            if (++index >= queueSize)
             {
-                if (m_repeatMode == 2)
-                {
-                    nextIndex = 0;
-                }
-                else
-                {
-                    qDebug() << "SongViewModel: Reached end of song list, stopping";
-                    return;
-                }
+                if (m_repeatMode != 2)
+                    break;
+                index = 0;
             }
+            upcoming.append(m_playQueue->songIdAt(index));
         }
-        playSongAtIndex(songList, nextIndex);
     }
+    return upcoming;
 }
 
-void SongViewModel::previousSong()
+void SongViewModel::setShuffleSeed(qint64 seed)
+{
+    // Reproducible shuffle for benchmarks and tests; negative goes back to random
+    if (seed < 0)
+        m_shuffleOrder.clearSeed();
+    else
+        m_shuffleOrder.setSeed(quint32(seed));
+    if (m_shuffle)
+    {
+        m_shuffleOrder.reset(m_playQueue->songIds(), m_currentSongId);
+        disarmNextSong();
+        updatePrefetch();
+    }
+}
+
+void SongViewModel::updatePrefetch()
 {
-    QVariantList songList = AppState::instance()->currentPlaylistId() != -1
-                                ? AppState::instance()->currentMediaFiles()
-                                : m_allSongs;
+    m_prefetcher->setUpcoming(upcomingSongIds(m_prefetcher->trackCount()));
+}
 
-    if (songList.isEmpty())
+void SongViewModel::previousSong()
+{
+    int queueSize = m_playQueue->count();
+    if (queueSize == 0)
     {
         qDebug() << "SongViewModel: No songs available to play";
         return;
     }
 
-    int currentIndex = findCurrentSongIndex(songList);
+    int currentIndex = m_playQueue->currentIndex();
+    int prevIndex;
     if (m_repeatMode == 1)
     {
-        playSongAtIndex(songList, currentIndex);
+        prevIndex = qMax(currentIndex, 0);
+    }
+    else if (m_shuffle)
+    {
+        // Step back through the songs shuffle already played
+        prevIndex = m_playQueue->songIds().indexOf(m_shuffleOrder.previous());
+        if (prevIndex < 0)
+        {
+            qDebug() << "SongViewModel: Reached start of shuffle history, stopping";
+            return;
+        }
     }
     else
     {
-        int prevIndex;
-        if (m_shuffle)
+        prevIndex = m_playQueue->previousIndex(m_repeatMode == 2);
+        if (prevIndex < 0)
         {
-            prevIndex = QRandomGenerator::global()->bounded(songList.size());
-            while (prevIndex == currentIndex && songList.size() > 1)
-            {
-                prevIndex = QRandomGenerator::global()->bounded(songList.size());
-            }
+            qDebug() << "SongViewModel: Reached start of song list, stopping";
+            return;
         }
+    }
+    playSongAtIndex(prevIndex);
+}
+
+void SongViewModel::connectPlayer(QMediaPlayer *player)
+{
+    // Both players stay connected; only the one currently playing drives the view
+    connect(player, &QMediaPlayer::mediaStatusChanged, this, [this, player](QMediaPlayer::MediaStatus status)
+            {
+        if (player == m_mediaPlayer)
+            onMediaStatusChanged(status);
         else
-        {
-            prevIndex = currentIndex - 1;
-            if (prevIndex < 0)
+            onNextMediaStatusChanged(status); });
+    connect(player, &QMediaPlayer::playbackStateChanged, this, [this, player](QMediaPlayer::PlaybackState state)
             {
-                if (m_repeatMode == 2)
-                {
-                    prevIndex = songList.size() - 1;
-                }
-                else
-                {
-                    qDebug() << "SongViewModel: Reached start of song list, stopping";
-                    return;
-                }
-            }
-        }
-        playSongAtIndex(songList, prevIndex);
+        if (player == m_mediaPlayer)
+            onPlaybackStateChanged(state); });
+    connect(player, &QMediaPlayer::positionChanged, this, [this, player](qint64 position)
+            {
+        if (player == m_mediaPlayer)
+            onPositionChanged(position); });
+    connect(player, &QMediaPlayer::durationChanged, this, [this, player](qint64 duration)
+            {
+        if (player == m_mediaPlayer)
+            onDurationChanged(duration); });
+    connect(player, &QMediaPlayer::errorOccurred, this, [this, player](QMediaPlayer::Error error, const QString &errorString)
+            {
+        if (player == m_mediaPlayer)
+            onErrorOccurred(error, errorString);
+        else
+            qDebug() << "SongViewModel: Could not pre-arm next song:" << errorString; });
+}
+
+void SongViewModel::setGaplessLeadTimeMs(int ms)
+{
+    if (ms < 0 || m_gaplessLeadTimeMs == ms)
+        return;
+    m_gaplessLeadTimeMs = ms;
+    emit gaplessLeadTimeMsChanged();
+}
+
+void SongViewModel::armNextSong()
+{
+    int nextIndex = followingIndex();
+    if (nextIndex < 0)
+        return;
+
+    m_armedSongId = m_playQueue->songIdAt(nextIndex);
+    QUrl url = StreamCache::instance()->playbackUrl(m_armedSongId, QUrl(m_songModel->getStreamUrl(m_armedSongId)));
+    if (m_audioEngine)
+    {
+        m_audioEngine->queueNext(url, m_crossfadeMs, trackGain(m_armedSongId), openStream(m_armedSongId, url));
     }
+    else
+    {
+        m_nextAudioOutput->setVolume(qMin(m_volume * trackGain(m_armedSongId), 1.0));
+        setPlayerSource(m_nextPlayer, m_armedSongId, url);
+    }
+    qDebug() << "SongViewModel: Pre-arming next song, ID:" << m_armedSongId;
+}
+
+void SongViewModel::disarmNextSong()
+{
+    if (m_armedSongId == -1)
+        return;
+    m_armedSongId = -1;
+    if (m_audioEngine)
+        m_audioEngine->clearNext();
+    else
+        setPlayerSource(m_nextPlayer, -1, QUrl());
+}
+
+bool SongViewModel::switchToArmedPlayer(int songId)
+{
+    if (m_audioEngine)
+    {
+        // The engine already moved on to the armed song by itself
+        if (!m_armedSongStarted || songId != m_armedSongId)
+            return false;
+        m_armedSongId = -1;
+        return true;
+    }
+
+    QMediaPlayer::MediaStatus status = m_nextPlayer->mediaStatus();
+    if (songId != m_armedSongId || (status != QMediaPlayer::LoadedMedia && status != QMediaPlayer::BufferedMedia))
+        return false;
+
+    m_mediaPlayer->stop();
+    m_mediaPlayer->setAudioBufferOutput(nullptr);
+    std::swap(m_mediaPlayer, m_nextPlayer);
+    std::swap(m_audioOutput, m_nextAudioOutput);
+    m_mediaPlayer->setAudioBufferOutput(m_spectrumAnalyzer->tap());
+    m_mediaPlayer->play();
+    m_armedSongId = -1;
+    setPlayerSource(m_nextPlayer, -1, QUrl());
+    emit durationChanged();
+    m_clock->sync(backendPosition());
+    emit isPlayingChanged();
+    return true;
+}
+
+bool SongViewModel::reopenAt(qint64 position, const SeekIndex::Point &point)
+{
+    // The cache fills front to back, so a target far past it would wait for
+    // most of the song to download; the player fetches it with a ranged
+    // request instead while the fill carries on
+    CachedStream *stream = qobject_cast<CachedStream *>(m_mediaPlayer->sourceDevice());
+    qint64 duration = m_mediaPlayer->duration();
+    if (!stream || m_currentSongId < 0)
+        return false;
+    qint64 target = point.byteOffset;
+    if (target <= 0 && stream->totalSize() > 0 && duration > 0)
+        target = stream->totalSize() * position / duration;
+    if (target - stream->cachedBytes() < FarSeekBytes)
+        return false;
+
+    qDebug() << "SongViewModel: Seek to byte" << target << "is past the cache fill at" << stream->cachedBytes() << ", streaming from the network";
+    bool playing = isPlaying();
+    m_restorePosition = position;
+    setPlayerSource(m_mediaPlayer, -1, QUrl(m_songModel->getStreamUrl(m_currentSongId)));
+    if (playing)
+        m_mediaPlayer->play();
+    return true;
+}
+
+CachedStream *SongViewModel::openStream(int songId, const QUrl &url)
+{
+    CachedStream *stream = StreamCache::instance()->openStream(songId, url);
+    // Timed on what the player consumes rather than on the fill
+    if (stream)
+        connect(stream, &CachedStream::firstBytesRead, m_metrics, [this, songId]()
+                { m_metrics->mark(PlaybackMetrics::FirstBytes, songId); });
+    return stream;
+}
+
+void SongViewModel::setPlayerSource(QMediaPlayer *player, int songId, const QUrl &url)
+{
+    // A song that is not fully cached is read from the cache as it fills,
+    // so the player does not download it a second time
+    QIODevice *previous = player->sourceDevice();
+    if (CachedStream *stream = qobject_cast<CachedStream *>(previous))
+        stream->setInterrupted(true);
+    CachedStream *stream = songId >= 0 ? openStream(songId, url) : nullptr;
+    if (stream)
+    {
+        stream->setParent(player);
+        player->setSourceDevice(stream, url);
+    }
+    else
+    {
+        player->setSource(url);
+    }
+    if (previous)
+        previous->deleteLater();
 }
 
 void SongViewModel::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
 {
     qDebug() << "SongViewModel: Media status changed:" << status;
+    // Opening a song gets the CPU and disk to itself
+    m_loudnessAnalyzer->setPaused(status == QMediaPlayer::LoadingMedia || status == QMediaPlayer::BufferingMedia ||
+                                  status == QMediaPlayer::StalledMedia);
+    if (status == QMediaPlayer::LoadedMedia)
+        m_metrics->mark(PlaybackMetrics::Loaded);
+    else if (status == QMediaPlayer::BufferedMedia)
+        m_metrics->mark(PlaybackMetrics::Buffered);
+    if (status == QMediaPlayer::LoadedMedia && m_restorePosition > 0 && !m_audioEngine)
+    {
+        m_mediaPlayer->setPosition(m_restorePosition);
+        m_restorePosition = -1;
+    }
+    if (status != QMediaPlayer::EndOfMedia)
+        return;
+
+    m_gapTimer.start();
+    nextSong();
+    if (m_mediaPlayer->playbackState() != QMediaPlayer::PlayingState)
+        m_gapTimer.invalidate();
+}
+
+void SongViewModel::onNextMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    qDebug() << "SongViewModel: Next song media status changed:" << status;
 }
 
 void SongViewModel::onPlaybackStateChanged(QMediaPlayer::PlaybackState state)
 {
+    m_spectrumAnalyzer->setActive(state == QMediaPlayer::PlayingState);
     emit isPlayingChanged();
     qDebug() << "SongViewModel: Playback state changed:" << state;
 }
 
 void SongViewModel::onPositionChanged(qint64 position)
 {
-    emit positionChanged();
+    if (position > 0)
+        m_metrics->mark(PlaybackMetrics::Audible);
+
+    // The gap runs from end of media to the first position report of the new
+    // song, minus the audio the new song has already played by then
+    if (m_gapTimer.isValid() && position > 0)
+    {
+        m_lastTransitionGapMs = qMax<qint64>(m_gapTimer.elapsed() - position, 0);
+        m_gapTimer.invalidate();
+        emit lastTransitionGapMsChanged();
+        qDebug() << "SongViewModel: Track transition gap:" << m_lastTransitionGapMs << "ms";
+    }
+
+    if (m_seekTimer.isValid() && position > m_seekTarget)
+    {
+        m_lastSeekLatencyMs = m_seekTimer.elapsed();
+        m_seekTimer.invalidate();
+        emit lastSeekLatencyMsChanged();
+        qDebug() << "SongViewModel: Seek to audio took" << m_lastSeekLatencyMs << "ms"
+                 << (m_seekIndexed ? "from the seek index" : "without a seek index");
+    }
+
+    // The engine needs the next song early enough to overlap the crossfade
+    qint64 remaining = duration() - position;
+    qint64 leadTime = m_gaplessLeadTimeMs + (m_audioEngine ? m_crossfadeMs : 0);
+    if (m_armedSongId == -1 && duration() > 0 && remaining <= leadTime)
+        armNextSong();
+    m_clock->sync(position);
+}
+
+void SongViewModel::onEngineNextTrackStarted()
+{
+    // Mixed in on the sample the previous song ended, or faded over it
+    if (m_lastTransitionGapMs != 0)
+    {
+        m_lastTransitionGapMs = 0;
+        emit lastTransitionGapMsChanged();
+    }
+    m_armedSongStarted = true;
+    nextSong();
+    m_armedSongStarted = false;
+}
+
+void SongViewModel::onEngineFinished()
+{
+    m_gapTimer.start();
+    nextSong();
+    if (!m_audioEngine->isPlaying())
+        m_gapTimer.invalidate();
 }
 
 void SongViewModel::onDurationChanged(qint64 duration)
@@ -293,20 +901,8 @@ void SongViewModel::onErrorOccurred(QMediaPlayer::Error error, const QString &er
 
 void SongViewModel::onSongsFetched()
 {
-    m_allSongs.clear();
-    for (int i = 0; i < m_songModel->rowCount(); ++i)
-    {
-        QModelIndex index = m_songModel->index(i, 0);
-        QVariantMap song;
-        song["id"] = m_songModel->data(index, SongModel::IdRole);
-        song["title"] = m_songModel->data(index, SongModel::TitleRole);
-        song["artists"] = m_songModel->data(index, SongModel::ArtistsRole);
-        song["file_path"] = m_songModel->data(index, SongModel::FilePathRole);
-        song["genres"] = m_songModel->data(index, SongModel::GenresRole);
-        m_allSongs.append(song);
-    }
     m_allSongsLoaded = true;
     emit allSongsFetched();
     emit allSongsLoadedChanged();
-    qDebug() << "SongViewModel: All songs fetched, count:" << m_allSongs.size();
+    qDebug() << "SongViewModel: All songs fetched, count:" << m_songModel->songIds().size();
 }
\ No newline at end of file
@@ -2,37 +2,79 @@
 #include <QObject>
 #include <QMediaPlayer>
 #include <QAudioOutput>
+#include <QElapsedTimer>
 #include "SongModel.hpp"
+#include "StreamPrefetcher.hpp"
+#include "PlayQueue.hpp"
+#include "ShuffleOrder.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "PlaybackClock.hpp"
+#include "PlaybackSession.hpp"
+#include "PlaybackMetrics.hpp"
+#include "SeekIndex.hpp"
+
+class AudioEngine;
+class CachedStream;
+class LoudnessAnalyzer;
 
 class SongViewModel : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(SongModel *songModel READ songModel CONSTANT)
+    Q_PROPERTY(PlayQueue *playQueue READ playQueue CONSTANT)
+    Q_PROPERTY(SpectrumAnalyzer *spectrumAnalyzer READ spectrumAnalyzer CONSTANT)
+    Q_PROPERTY(PlaybackMetrics *playbackMetrics READ playbackMetrics CONSTANT)
+    Q_PROPERTY(int currentSongId READ currentSongId NOTIFY currentSongChanged)
     Q_PROPERTY(QString currentSongTitle READ currentSongTitle NOTIFY currentSongChanged)
     Q_PROPERTY(QString currentSongArtist READ currentSongArtist NOTIFY currentSongChanged)
     Q_PROPERTY(bool isPlaying READ isPlaying NOTIFY isPlayingChanged)
     Q_PROPERTY(qint64 position READ position NOTIFY positionChanged)
     Q_PROPERTY(qint64 duration READ duration NOTIFY durationChanged)
+    Q_PROPERTY(QString timeText READ timeText NOTIFY timeTextChanged)
+    Q_PROPERTY(int positionNotifyMs READ positionNotifyMs WRITE setPositionNotifyMs NOTIFY positionNotifyMsChanged)
     Q_PROPERTY(qreal volume READ volume WRITE setVolume NOTIFY volumeChanged)
     Q_PROPERTY(bool shuffle READ shuffle WRITE setShuffle NOTIFY shuffleChanged)
     Q_PROPERTY(int repeatMode READ repeatMode WRITE setRepeatMode NOTIFY repeatModeChanged)
     Q_PROPERTY(bool muted READ muted WRITE setMuted NOTIFY mutedChanged)
     Q_PROPERTY(bool allSongsLoaded READ allSongsLoaded NOTIFY allSongsLoadedChanged)
+    Q_PROPERTY(int gaplessLeadTimeMs READ gaplessLeadTimeMs WRITE setGaplessLeadTimeMs NOTIFY gaplessLeadTimeMsChanged)
+    Q_PROPERTY(qint64 lastTransitionGapMs READ lastTransitionGapMs NOTIFY lastTransitionGapMsChanged)
+    Q_PROPERTY(qint64 lastSeekLatencyMs READ lastSeekLatencyMs NOTIFY lastSeekLatencyMsChanged)
+    Q_PROPERTY(bool audioEngineEnabled READ audioEngineEnabled WRITE setAudioEngineEnabled NOTIFY audioEngineEnabledChanged)
+    Q_PROPERTY(int crossfadeMs READ crossfadeMs WRITE setCrossfadeMs NOTIFY crossfadeMsChanged)
+    Q_PROPERTY(bool loudnessNormalization READ loudnessNormalization WRITE setLoudnessNormalization NOTIFY loudnessNormalizationChanged)
 
 public:
     explicit SongViewModel(QObject *parent = nullptr);
 
     SongModel *songModel() const { return m_songModel; }
+    PlayQueue *playQueue() const { return m_playQueue; }
+    SpectrumAnalyzer *spectrumAnalyzer() const { return m_spectrumAnalyzer; }
+    PlaybackMetrics *playbackMetrics() const { return m_metrics; }
+    int currentSongId() const { return m_currentSongId; }
     QString currentSongTitle() const { return m_currentSongTitle; }
     QString currentSongArtist() const { return m_currentSongArtists.join(", "); }
-    bool isPlaying() const { return m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState; }
-    qint64 position() const { return m_mediaPlayer->position(); }
-    qint64 duration() const { return m_mediaPlayer->duration(); }
-    qreal volume() const { return m_audioOutput->volume(); }
+    bool isPlaying() const;
+    qint64 position() const { return m_clock->position(); }
+    qint64 duration() const;
+    QString timeText() const { return m_clock->timeText(); }
+    int positionNotifyMs() const { return m_clock->notifyIntervalMs(); }
+    void setPositionNotifyMs(int ms);
+    qreal volume() const { return m_volume; }
     bool shuffle() const { return m_shuffle; }
     int repeatMode() const { return m_repeatMode; }
     bool muted() const { return m_muted; }
     bool allSongsLoaded() const { return m_allSongsLoaded; }
+    int gaplessLeadTimeMs() const { return m_gaplessLeadTimeMs; }
+    void setGaplessLeadTimeMs(int ms);
+    qint64 lastTransitionGapMs() const { return m_lastTransitionGapMs; }
+    qint64 lastSeekLatencyMs() const { return m_lastSeekLatencyMs; }
+    bool audioEngineEnabled() const { return m_audioEngine != nullptr; }
+    void setAudioEngineEnabled(bool enabled);
+    int crossfadeMs() const { return m_crossfadeMs; }
+    void setCrossfadeMs(int ms);
+    bool loudnessNormalization() const { return m_loudnessNormalization; }
+    void setLoudnessNormalization(bool enabled);
 
     Q_INVOKABLE void setVolume(qreal volume);
     Q_INVOKABLE void search(const QString &query);
@@ -44,6 +86,7 @@ public:
     Q_INVOKABLE void nextSong();
     Q_INVOKABLE void previousSong();
     Q_INVOKABLE void setShuffle(bool shuffle);
+    Q_INVOKABLE void setShuffleSeed(qint64 seed);
     Q_INVOKABLE void setRepeatMode(int mode);
     Q_INVOKABLE void setMuted(bool muted);
 
@@ -52,6 +95,8 @@ signals:
     void isPlayingChanged();
     void positionChanged();
     void durationChanged();
+    void timeTextChanged();
+    void positionNotifyMsChanged();
     void volumeChanged();
     void shuffleChanged();
     void repeatModeChanged();
@@ -59,6 +104,12 @@ signals:
     void errorOccurred(const QString &error);
     void allSongsFetched();
     void allSongsLoadedChanged();
+    void gaplessLeadTimeMsChanged();
+    void lastTransitionGapMsChanged();
+    void lastSeekLatencyMsChanged();
+    void audioEngineEnabledChanged();
+    void crossfadeMsChanged();
+    void loudnessNormalizationChanged();
 
 private slots:
     void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
@@ -67,21 +118,85 @@ private slots:
     void onDurationChanged(qint64 duration);
     void onErrorOccurred(QMediaPlayer::Error error, const QString &errorString);
     void onSongsFetched();
+    void onNextMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void refreshQueue();
+    void onEngineNextTrackStarted();
+    void onEngineFinished();
 
 private:
-    QString normalizeString(const QString &str) const;
-    int findCurrentSongIndex(const QVariantList &songList) const;
-    void playSongAtIndex(const QVariantList &songList, int index);
+    void connectPlayer(QMediaPlayer *player);
+    qint64 backendPosition() const;
+    int followingIndex();
+    QList<int> upcomingSongIds(int count);
+    void updatePrefetch();
+    void armNextSong();
+    void disarmNextSong();
+    bool switchToArmedPlayer(int songId);
+    CachedStream *openStream(int songId, const QUrl &url);
+    // Switches the player from its cache stream to the network for a far seek
+    bool reopenAt(qint64 position, const SeekIndex::Point &point);
+    void setPlayerSource(QMediaPlayer *player, int songId, const QUrl &url);
+    qreal trackGain(int songId) const;
+    void applyVolume();
+    void restoreSession();
+    PlaybackSnapshot sessionSnapshot(bool withSongs) const;
+
+    QList<int> queueSource(int playlistId) const;
+    void startSong(int songId, const QString &title, const QStringList &artists);
+    void playSongAtIndex(int index);
 
     SongModel *m_songModel;
+    // The whole library, unpaged and never searched; the view's model only
+    // holds the pages scrolled into view, so the queue is built from this
+    SongModel *m_library;
+    // Interpolates between backend reports; position() comes from here
+    PlaybackClock *m_clock;
     QMediaPlayer *m_mediaPlayer;
     QAudioOutput *m_audioOutput;
+    // Second player that opens the following song ahead of time; the two
+    // players swap roles at every gapless transition
+    QMediaPlayer *m_nextPlayer;
+    QAudioOutput *m_nextAudioOutput;
+    int m_armedSongId = -1;
+    int m_gaplessLeadTimeMs;
+    QElapsedTimer m_gapTimer;
+    qint64 m_lastTransitionGapMs = -1;
+    // From a seek while playing to the first position report past its target
+    QElapsedTimer m_seekTimer;
+    qint64 m_seekTarget = 0;
+    bool m_seekIndexed = false;
+    qint64 m_lastSeekLatencyMs = -1;
+    // Replaces both players when enabled; it mixes the armed song in itself
+    AudioEngine *m_audioEngine = nullptr;
+    int m_crossfadeMs;
+    bool m_armedSongStarted = false;
+    // Shuffled order is fixed ahead of time so the prefetcher knows it
+    ShuffleOrder m_shuffleOrder;
+    StreamPrefetcher *m_prefetcher;
+    PlayQueue *m_playQueue;
+    // Where the queue came from: a playlist id, or -1 for the library. The
+    // queue follows changes to that list only; browsing elsewhere leaves it
+    // alone until a song is played from there
+    int m_queuePlaylistId = -1;
+    QString m_queuePlaylistName;
+    LoudnessAnalyzer *m_loudnessAnalyzer;
+    bool m_loudnessNormalization;
+    // Taps whichever player is current; the engine path is not analyzed
+    SpectrumAnalyzer *m_spectrumAnalyzer;
+    bool m_seekIndexEnabled;
+    // Restored song waits opened but paused; position is applied once it loads
+    PlaybackSession *m_session;
+    qint64 m_restorePosition = -1;
+    QUrl m_restoreUrl;
+    // Time to first audio of every playSong()
+    PlaybackMetrics *m_metrics;
+    int m_currentSongId = -1;
     QString m_currentSongTitle;
     QStringList m_currentSongArtists;
     bool m_shuffle = false;
     int m_repeatMode = 0; // 0: No repeat, 1: Repeat one, 2: Repeat all
     bool m_muted = false;
+    qreal m_volume = 0.5;
     qreal m_previousVolume = 0.5;
     bool m_allSongsLoaded = false;
-    QVariantList m_allSongs;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "SpectrumItem.hpp"
+#include <QPainter>
+#include <QQuickWindow>
+
+SpectrumItem::SpectrumItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+{
+    connect(this, &QQuickItem::windowChanged, this, &SpectrumItem::onWindowChanged);
+}
+
+void SpectrumItem::setAnalyzer(SpectrumAnalyzer *analyzer)
+{
+    if (m_analyzer == analyzer)
+        return;
+    if (m_analyzer)
+        disconnect(m_analyzer, nullptr, this, nullptr);
+    m_analyzer = analyzer;
+    if (m_analyzer)
+        connect(m_analyzer, &SpectrumAnalyzer::activeChanged, this, [this]()
+                { update(); });
+    emit analyzerChanged();
+    update();
+}
+
+void SpectrumItem::setColor(const QColor &color)
+{
+    if (m_color == color)
+        return;
+    m_color = color;
+    emit colorChanged();
+    update();
+}
+
+void SpectrumItem::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(m_spacing, spacing))
+        return;
+    m_spacing = spacing;
+    emit spacingChanged();
+    update();
+}
+
+void SpectrumItem::onWindowChanged(QQuickWindow *window)
+{
+    if (window)
+        connect(window, &QQuickWindow::frameSwapped, this, &SpectrumItem::onFrameSwapped);
+}
+
+void SpectrumItem::onFrameSwapped()
+{
+    // Keeps asking for frames until the bars have fallen back to silence
+    if (isVisible() && m_analyzer && (m_analyzer->isActive() || m_drawn))
+        update();
+}
+
+void SpectrumItem::paint(QPainter *painter)
+{
+    m_drawn = false;
+    if (!m_analyzer)
+        return;
+
+    float levels[SpectrumAnalyzer::BandCount];
+    m_analyzer->bands(levels);
+    const qreal barWidth = (width() - m_spacing * (SpectrumAnalyzer::BandCount - 1)) / SpectrumAnalyzer::BandCount;
+    if (barWidth <= 0)
+        return;
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(m_color);
+    for (int band = 0; band < SpectrumAnalyzer::BandCount; ++band)
+    {
+        qreal barHeight = levels[band] * height();
+        if (barHeight <= 0)
+            continue;
+        m_drawn = true;
+        painter->drawRect(QRectF(band * (barWidth + m_spacing), height() - barHeight, barWidth, barHeight));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <QQuickPaintedItem>
+#include <QColor>
+#include <QPointer>
+#include "SpectrumAnalyzer.hpp"
+
+// Bars of a SpectrumAnalyzer, repainted every frame while it has anything
+// to show and idle otherwise
+class SpectrumItem : public QQuickPaintedItem
+{
+    Q_OBJECT
+    Q_PROPERTY(SpectrumAnalyzer *analyzer READ analyzer WRITE setAnalyzer NOTIFY analyzerChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+
+public:
+    explicit SpectrumItem(QQuickItem *parent = nullptr);
+
+    SpectrumAnalyzer *analyzer() const { return m_analyzer; }
+    void setAnalyzer(SpectrumAnalyzer *analyzer);
+    QColor color() const { return m_color; }
+    void setColor(const QColor &color);
+    qreal spacing() const { return m_spacing; }
+    void setSpacing(qreal spacing);
+
+    void paint(QPainter *painter) override;
+
+signals:
+    void analyzerChanged();
+    void colorChanged();
+    void spacingChanged();
+
+private slots:
+    void onFrameSwapped();
+
+private:
+    void onWindowChanged(QQuickWindow *window);
+
+    QPointer<SpectrumAnalyzer> m_analyzer;
+    QColor m_color = QColor("#2b6cb0");
+    qreal m_spacing = 2.0;
+    // Whether the last frame drew any bar above the baseline
+    bool m_drawn = false;
+};
\ No newline at end of file
@@ -1,9 +1,18 @@
 #include "UartViewModel.hpp"
+#include <QTimer>
 #include <QDebug>
 
+namespace
+{
+    constexpr int VolumeCoalesceMs = 50;
+}
+
 UartViewModel::UartViewModel(SongViewModel *songViewModel, QObject *parent)
-    : QObject(parent), m_uartModel(new UartModel(this)), m_songViewModel(songViewModel)
+    : QObject(parent), m_uartModel(new UartModel(this)), m_songViewModel(songViewModel), m_volumeTimer(new QTimer(this))
 {
+    m_volumeTimer->setSingleShot(true);
+    m_volumeTimer->setInterval(VolumeCoalesceMs);
+    connect(m_volumeTimer, &QTimer::timeout, this, &UartViewModel::applyPendingVolume);
     connect(m_uartModel, &UartModel::playPauseRequested, this, &UartViewModel::onPlayPauseRequested);
     connect(m_uartModel, &UartModel::nextSongRequested, this, &UartViewModel::onNextSongRequested);
     connect(m_uartModel, &UartModel::previousSongRequested, this, &UartViewModel::onPreviousSongRequested);
@@ -66,10 +75,20 @@ void UartViewModel::onPreviousSongRequested()
 
 void UartViewModel::onVolumeChanged(int volume)
 {
-    if (m_songViewModel)
+    // Only the latest step of a sweep is applied, at most once per interval;
+    // the timer is not restarted so a long sweep still follows the knob
+    m_pendingVolume = volume;
+    if (!m_volumeTimer->isActive())
+        m_volumeTimer->start();
+}
+
+void UartViewModel::applyPendingVolume()
+{
+    if (m_songViewModel && m_pendingVolume >= 0)
     {
-        qreal scaledVolume = volume / 100.0;
+        qreal scaledVolume = m_pendingVolume / 100.0;
         m_songViewModel->setVolume(scaledVolume);
-        qDebug() << "UartViewModel: Volume changed to" << volume << "% (" << scaledVolume << ")";
+        qDebug() << "UartViewModel: Volume changed to" << m_pendingVolume << "% (" << scaledVolume << ")";
     }
+    m_pendingVolume = -1;
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "UartModel.hpp"
 #include "SongViewModel.hpp"
 
+class QTimer;
+
 class UartViewModel : public QObject
 {
     Q_OBJECT
@@ -32,8 +34,12 @@ private slots:
     void onNextSongRequested();
     void onPreviousSongRequested();
     void onVolumeChanged(int volume);
+    void applyPendingVolume();
 
 private:
     UartModel *m_uartModel;
     SongViewModel *m_songViewModel;
+    // Knob steps arrive far faster than volume changes need to be applied
+    QTimer *m_volumeTimer;
+    int m_pendingVolume = -1;
 };
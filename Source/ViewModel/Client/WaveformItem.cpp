@@ -0,0 +1,99 @@
+#include "WaveformItem.hpp"
+#include "WaveformService.hpp"
+#include <QPainter>
+#include <QtMath>
+
+WaveformItem::WaveformItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+{
+    connect(WaveformService::instance(), &WaveformService::waveformReady, this, &WaveformItem::onWaveformReady);
+}
+
+void WaveformItem::setSongId(int songId)
+{
+    if (m_songId == songId)
+        return;
+    m_songId = songId;
+    emit songIdChanged();
+    setWaveform(songId >= 0 ? WaveformService::instance()->waveform(songId) : QByteArray());
+}
+
+void WaveformItem::setProgress(qreal progress)
+{
+    progress = qBound<qreal>(0.0, progress, 1.0);
+    if (qFuzzyCompare(m_progress + 1.0, progress + 1.0))
+        return;
+
+    // Only the columns between the old and new position change colour
+    qreal from = qMin(m_progress, progress) * width();
+    qreal to = qMax(m_progress, progress) * width();
+    m_progress = progress;
+    emit progressChanged();
+    if (available())
+        update(QRect(qFloor(from) - 1, 0, qCeil(to - from) + 2, qCeil(height())));
+}
+
+void WaveformItem::setColor(const QColor &color)
+{
+    if (m_color == color)
+        return;
+    m_color = color;
+    emit colorChanged();
+    update();
+}
+
+void WaveformItem::setProgressColor(const QColor &color)
+{
+    if (m_progressColor == color)
+        return;
+    m_progressColor = color;
+    emit progressColorChanged();
+    update();
+}
+
+void WaveformItem::onWaveformReady(int songId)
+{
+    if (songId == m_songId)
+        setWaveform(WaveformService::instance()->waveform(songId));
+}
+
+void WaveformItem::setWaveform(const QByteArray &waveform)
+{
+    bool wasAvailable = available();
+    m_waveform = waveform;
+    if (wasAvailable != available())
+        emit availableChanged();
+    update();
+}
+
+void WaveformItem::paint(QPainter *painter)
+{
+    const int buckets = int(m_waveform.size() / 2);
+    const int columns = qFloor(width());
+    if (buckets == 0 || columns <= 0)
+        return;
+
+    const qreal middle = height() / 2.0;
+    const qreal scale = middle / 127.0;
+    const int played = qRound(m_progress * columns);
+    const QRect dirty = painter->clipBoundingRect().toAlignedRect();
+    const int first = dirty.isEmpty() ? 0 : qMax(0, dirty.left());
+    const int last = dirty.isEmpty() ? columns : qMin(columns, dirty.right() + 1);
+    const qint8 *data = reinterpret_cast<const qint8 *>(m_waveform.constData());
+
+    for (int column = first; column < last; ++column)
+    {
+        // Every bucket under the column folds into one line
+        int begin = int(qint64(column) * buckets / columns);
+        int end = qMax(begin + 1, int(qint64(column + 1) * buckets / columns));
+        int low = data[begin * 2];
+        int high = data[begin * 2 + 1];
+        for (int bucket = begin + 1; bucket < end; ++bucket)
+        {
+            low = qMin(low, int(data[bucket * 2]));
+            high = qMax(high, int(data[bucket * 2 + 1]));
+        }
+        painter->setPen(column < played ? m_progressColor : m_color);
+        painter->drawLine(QPointF(column + 0.5, middle - high * scale), QPointF(column + 0.5, middle - low * scale + 1.0));
+    }
+}
\ No newline at end of file
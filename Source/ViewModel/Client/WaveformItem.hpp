@@ -0,0 +1,50 @@
+#pragma once
+#include <QQuickPaintedItem>
+#include <QByteArray>
+#include <QColor>
+
+// Draws a song's waveform overview behind the seek slider, one line per
+// pixel column, with the played part in progressColor
+class WaveformItem : public QQuickPaintedItem
+{
+    Q_OBJECT
+    Q_PROPERTY(int songId READ songId WRITE setSongId NOTIFY songIdChanged)
+    Q_PROPERTY(qreal progress READ progress WRITE setProgress NOTIFY progressChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(QColor progressColor READ progressColor WRITE setProgressColor NOTIFY progressColorChanged)
+    Q_PROPERTY(bool available READ available NOTIFY availableChanged)
+
+public:
+    explicit WaveformItem(QQuickItem *parent = nullptr);
+
+    int songId() const { return m_songId; }
+    void setSongId(int songId);
+    qreal progress() const { return m_progress; }
+    void setProgress(qreal progress);
+    QColor color() const { return m_color; }
+    void setColor(const QColor &color);
+    QColor progressColor() const { return m_progressColor; }
+    void setProgressColor(const QColor &color);
+    bool available() const { return !m_waveform.isEmpty(); }
+
+    void paint(QPainter *painter) override;
+
+signals:
+    void songIdChanged();
+    void progressChanged();
+    void colorChanged();
+    void progressColorChanged();
+    void availableChanged();
+
+private slots:
+    void onWaveformReady(int songId);
+
+private:
+    void setWaveform(const QByteArray &waveform);
+
+    int m_songId = -1;
+    qreal m_progress = 0.0;
+    QColor m_color = QColor("#cbd5e0");
+    QColor m_progressColor = QColor("#2b6cb0");
+    QByteArray m_waveform;
+};
\ No newline at end of file
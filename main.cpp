@@ -7,6 +7,9 @@
 #include "AppState.hpp"
 #include "AdminViewModel.hpp"
 #include "UartViewModel.hpp"
+#include "HttpClient.hpp"
+#include "WaveformItem.hpp"
+#include "SpectrumItem.hpp"
 
 int main(int argc, char *argv[])
 {
@@ -17,6 +20,12 @@ int main(int argc, char *argv[])
     engine.addImportPath("qrc:/");
     qmlRegisterSingletonType(QUrl("qrc:/Source/View/Helper/NavigationManager.qml"), "NavigationManager", 1, 0, "NavigationManager");
     qmlRegisterSingletonInstance<AppState>("AppState", 1, 0, "AppState", AppState::instance());
+    qmlRegisterType<WaveformItem>("Waveform", 1, 0, "WaveformItem");
+    qmlRegisterType<SpectrumItem>("Spectrum", 1, 0, "SpectrumItem");
+
+    // Open the shared connection early so the first requests skip the handshake
+    if (AppState::instance()->isAuthenticated())
+        HttpClient::instance()->warmUp();
 
     // Register AuthViewModel
     AuthViewModel authViewModel;